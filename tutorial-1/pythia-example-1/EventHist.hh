@@ -0,0 +1,194 @@
+#ifndef __EVENTHIST_HH__
+#define __EVENTHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file EventHist.hh
+///
+/// EventHist is a histogram for quantities that are filled several
+/// times per event (e.g. the rapidity of every particle), which gives
+/// correct statistical errors even though the entries from a given
+/// event are correlated:
+///
+/// \code
+///   EventHist particleRap(-15.0, 15.0, 0.5);
+///   for (...events...) {
+///     for (...particles...) particleRap.add_entry(rap);
+///     particleRap.end_event();
+///   }
+///   file << particleRap;   // binlo binmid binhi value error
+/// \endcode
+///
+/// During an event, the entries are collected in a scratch copy of the
+/// bins, keeping a list of the bins that were touched. At end_event()
+/// the event's total in each of those bins, X, is added to the bin's
+/// sum of X and sum of X^2, and the scratch bins are cleared; so the
+/// cost per event scales with the number of bins touched, not with the
+/// total number of bins.
+///
+/// The error on bin i is then estimated from the spread of X across
+/// events, error^2 = N/(N-1) (sum X^2 - (sum X)^2/N), with N the number
+/// of events (including those that contributed nothing to the bin).
+//----------------------------------------------------------------------
+
+#include<valarray>
+#include<vector>
+#include<cmath>
+#include<iostream>
+#include<cassert>
+#include<algorithm>
+
+class EventHist {
+public:
+  EventHist() {};
+
+  EventHist(double minv, double maxv, double bin_size) {
+    declare(minv, maxv, bin_size);
+  }
+
+  EventHist(double minv, double maxv, unsigned int n) {
+    declare(minv, maxv, n);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, double bin_size) {
+    declare(minv, maxv, unsigned(0.5+(maxv-minv)/bin_size));
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, unsigned int n) {
+    _minv = minv; _maxv = maxv; _dv = (maxv-minv)/n; _inv_dv = 1.0/_dv;
+    _sum.resize(n+1);
+    _sum2.resize(n+1);
+    _event.resize(n+1);
+    _is_touched.resize(n+1);
+    reset();
+  }
+
+  /// reset the contents of the histogram to zero (does not
+  /// modify the histogram bounds)
+  void reset() {
+    _sum  = 0.0;
+    _sum2 = 0.0;
+    _event = 0.0;
+    _is_touched.assign(_is_touched.size(), false);
+    _touched.clear();
+    _n_events = 0.0;
+  }
+
+  double min() const {return _minv;};
+  double max() const {return _maxv;};
+  /// returns the size of the histogram proper
+  unsigned int size() const {
+    unsigned outflow_sz = _sum.size();
+    assert(outflow_sz > 0); // help capture uninitialised histogram bugs
+    return outflow_sz-1;
+  }
+  /// returns the size of the histogram plus outflow bin
+  unsigned int outflow_size() const {return _sum.size();};
+
+  double binlo (int i) const {return i*_dv + _minv;};
+  double binhi (int i) const {return (i+1)*_dv + _minv;};
+  double binmid(int i) const {return (i+0.5)*_dv + _minv;};
+  double binsize()     const {return _dv;};
+
+  unsigned int bin(double v) const {
+    if (v >= _minv && v < _maxv) {
+      unsigned i = unsigned((v-_minv)*_inv_dv);
+      if (i < size()) return i;
+    }
+    return size();
+  }
+
+  /// add an entry for the current event
+  void add_entry(double v, double weight = 1.0) {
+    unsigned i = bin(v);
+    if (!_is_touched[i]) {
+      _is_touched[i] = true;
+      _touched.push_back(i);
+    }
+    _event[i] += weight;
+  }
+
+  /// fold the current event's entries into the histogram; should be
+  /// called once for every event, including those with no entries
+  void end_event() {
+    for (unsigned j = 0; j < _touched.size(); j++) {
+      unsigned i = _touched[j];
+      double x = _event[i];
+      _sum[i]  += x;
+      _sum2[i] += x*x;
+      _event[i] = 0.0;
+      _is_touched[i] = false;
+    }
+    _touched.clear();
+    _n_events += 1.0;
+  }
+
+  /// the contents of bin i (summed over completed events)
+  double operator[](unsigned i) const {return _sum[i];}
+  /// the statistical error on the contents of bin i
+  double error(unsigned i) const {
+    if (_n_events <= 1) return 0.0;
+    double var = _sum2[i] - _sum[i]*_sum[i]/_n_events;
+    return std::sqrt(std::max(0.0, var) * _n_events/(_n_events-1));
+  }
+  /// the sum over events of the square of the event's contribution
+  /// to bin i
+  double sum2(unsigned i) const {return _sum2[i];}
+
+  /// the number of completed events
+  double n_events() const {return _n_events;}
+
+  // Operations with constants ---------------------------------------
+  /// rescale the contents (and errors) by fact
+  EventHist & operator*=(double fact) {
+    _sum  *= fact;
+    _sum2 *= fact*fact;
+    return *this;
+  };
+  EventHist & operator/=(double fact) {
+    *this *= 1.0/fact;
+    return *this;
+  };
+
+  /// merge another histogram (with the same binning) into this one
+  EventHist & operator+=(const EventHist & other) {
+    assert(other.outflow_size() == outflow_size());
+    assert(other._touched.size() == 0); // no event in progress
+    _sum  += other._sum;
+    _sum2 += other._sum2;
+    _n_events += other._n_events;
+    return *this;
+  };
+
+private:
+  double _minv, _maxv, _dv, _inv_dv;
+  std::valarray<double> _sum, _sum2;
+  // scratch space for the event in progress
+  std::valarray<double>  _event;
+  std::vector<bool>      _is_touched;
+  std::vector<unsigned>  _touched;
+  double _n_events;
+};
+
+
+/// output the histogram with columns binlo, binmid, binhi, value and
+/// error; the output is multiplied by the factor norm.
+inline void output(const EventHist & hist,
+                   std::ostream * ostr = (&std::cout),
+                   double norm = 1.0) {
+  for (unsigned i = 0; i < hist.size(); i++) {
+    *ostr << hist.binlo(i)  << " "
+          << hist.binmid(i) << " "
+          << hist.binhi(i)  << " "
+          << hist[i]*norm   << " "
+          << hist.error(i)*norm << std::endl;
+  }
+}
+
+inline std::ostream & operator<<(std::ostream & ostr, const EventHist & hist) {
+  output(hist, &ostr);
+  return ostr;
+}
+
+#endif // __EVENTHIST_HH__
@@ -0,0 +1,129 @@
+#ifndef __EVENTKINEMATICS_HH__
+#define __EVENTKINEMATICS_HH__
+
+//----------------------------------------------------------------------
+/// \file EventKinematics.hh
+///
+/// EventKinematics holds the kinematics of the final-state particles
+/// of a Pythia8::Event as a "structure of arrays": one contiguous
+/// column each for px, py, pz, E, pt^2, rapidity, phi and mass, all
+/// computed in one go when the event is filled, e.g.
+///
+/// \code
+///   EventKinematics kinematics;
+///   ...
+///   kinematics.fill(pythia.event);
+///   for (unsigned i = 0; i < kinematics.size(); i++) {
+///     hist.add_entry(kinematics.rap(i));
+///   }
+/// \endcode
+///
+/// Entry i corresponds to the particle pythia.event[kinematics.index(i)].
+/// The derived quantities are computed in simple loops over the
+/// columns, one per quantity, which the compiler can vectorise. Reuse
+/// one object across events, so that the columns are not reallocated
+/// for each event.
+///
+/// The conventions follow those of fastjet's PseudoJet: phi is in the
+/// range [0, 2pi), the rapidity is computed with the mass set to
+/// zero if m^2 < 0 (and is +-max_rap() for massless particles along
+/// the beam) and the mass is negative if m^2 < 0.
+//----------------------------------------------------------------------
+
+#include "Pythia8/Event.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+class EventKinematics {
+public:
+  EventKinematics() {}
+  EventKinematics(const Pythia8::Event & event) {fill(event);}
+
+  /// (re)fill the columns with the final-state particles of event
+  void fill(const Pythia8::Event & event) {
+    _index.clear();
+    for (int i = 0; i < event.size(); ++i) {
+      if (event[i].isFinal()) _index.push_back(i);
+    }
+    unsigned n = _index.size();
+    _px.resize(n); _py.resize(n); _pz.resize(n); _E.resize(n);
+    _pt2.resize(n); _rap.resize(n); _phi.resize(n); _m.resize(n);
+    for (unsigned i = 0; i < n; i++) {
+      const Pythia8::Particle & p = event[_index[i]];
+      _px[i] = p.px(); _py[i] = p.py(); _pz[i] = p.pz(); _E[i] = p.e();
+    }
+    if (n > 0) _compute(n);
+  }
+
+  /// the number of final-state particles
+  unsigned size() const {return _index.size();}
+
+  /// the index in the event of entry i
+  int index(unsigned i) const {return _index[i];}
+
+  /// the kinematics of entry i
+  double px  (unsigned i) const {return _px[i];}
+  double py  (unsigned i) const {return _py[i];}
+  double pz  (unsigned i) const {return _pz[i];}
+  double E   (unsigned i) const {return _E[i];}
+  double pt2 (unsigned i) const {return _pt2[i];}
+  double pt  (unsigned i) const {return std::sqrt(_pt2[i]);}
+  double rap (unsigned i) const {return _rap[i];}
+  double phi (unsigned i) const {return _phi[i];}
+  double m   (unsigned i) const {return _m[i];}
+
+  /// the full columns, for loops over all the particles
+  const std::vector<double> & px_column () const {return _px;}
+  const std::vector<double> & py_column () const {return _py;}
+  const std::vector<double> & pz_column () const {return _pz;}
+  const std::vector<double> & E_column  () const {return _E;}
+  const std::vector<double> & pt2_column() const {return _pt2;}
+  const std::vector<double> & rap_column() const {return _rap;}
+  const std::vector<double> & phi_column() const {return _phi;}
+  const std::vector<double> & m_column  () const {return _m;}
+
+  /// the rapidity assigned to massless particles along the beam
+  static double max_rap() {return 1e5;}
+
+private:
+  void _compute(unsigned n) {
+    const double * px = &_px[0], * py = &_py[0], * pz = &_pz[0], * E = &_E[0];
+    double * pt2 = &_pt2[0], * rap = &_rap[0], * phi = &_phi[0], * m = &_m[0];
+
+    // pt^2 and the mass (using m to hold m^2 until the rapidity has
+    // been computed)
+    for (unsigned i = 0; i < n; i++) {
+      pt2[i] = px[i]*px[i] + py[i]*py[i];
+      m[i]   = (E[i] + pz[i])*(E[i] - pz[i]) - pt2[i];
+    }
+
+    // the rapidity, as 0.5 log((E+|pz|)^2/mt^2), which does not suffer
+    // from cancellations at large |pz|
+    const double rap_limit = max_rap();
+    for (unsigned i = 0; i < n; i++) {
+      double mt2 = pt2[i] + std::max(m[i], 0.0);
+      double E_plus_abs_pz = E[i] + std::abs(pz[i]);
+      // massless particles along the beam get max_rap()
+      double safe_mt2 = (mt2 > 0) ? mt2 : 1.0;
+      double abs_rap = 0.5 * std::log(E_plus_abs_pz*E_plus_abs_pz/safe_mt2);
+      abs_rap = (mt2 > 0) ? std::min(abs_rap, rap_limit) : rap_limit;
+      rap[i] = std::copysign(abs_rap, pz[i]);
+    }
+
+    for (unsigned i = 0; i < n; i++) {
+      m[i] = std::copysign(std::sqrt(std::abs(m[i])), m[i]);
+    }
+
+    const double twopi = 2*M_PI;
+    for (unsigned i = 0; i < n; i++) {
+      double phi_i = std::atan2(py[i], px[i]);
+      phi[i] = (phi_i < 0) ? phi_i + twopi : phi_i;
+    }
+  }
+
+  std::vector<int> _index;
+  std::vector<double> _px, _py, _pz, _E, _pt2, _rap, _phi, _m;
+};
+
+#endif // __EVENTKINEMATICS_HH__
@@ -8,6 +8,8 @@
 
 #include "Pythia8/Pythia.h"
 #include "SimpleHist.hh"
+#include "EventHist.hh"
+#include "EventKinematics.hh"
 #include <cmath>
 
 using namespace Pythia8;
@@ -29,20 +31,30 @@ int main() {
   int nEvents = 100;
   
   pythia.init();
-  SimpleHist particleRap(-15.0, 15.0, 0.5);
+  // many particles per event go into this histogram, so use an
+  // EventHist, which gets the errors right for correlated entries
+  EventHist particleRap(-15.0, 15.0, 0.5);
+  // the kinematics of the final-state particles of each event,
+  // computed in one pass (and reusing the same storage for each event)
+  EventKinematics kinematics;
   
   // Begin event loop. Generate event. Skip if error. List first one.
   for (int iEvent = 0; iEvent < nEvents; ++iEvent) {
     
-    if (!pythia.next()) continue;
+    // a failed event still counts as an event (with no entries), as
+    // in the normalisation to nEvents below
+    if (!pythia.next()) {
+      particleRap.end_event();
+      continue;
+    }
     
-    // Add an entry to the rapidity histogram for each particle
-    for (int i = 0; i < pythia.event.size(); ++i) {
-      if (!pythia.event[i].isFinal()) continue;
-
-      particleRap.add_entry(pythia.event[i].p().rap());
-      
+    // Add an entry to the rapidity histogram for each final-state
+    // particle
+    kinematics.fill(pythia.event);
+    for (unsigned i = 0; i < kinematics.size(); ++i) {
+      particleRap.add_entry(kinematics.rap(i));
     }
+    particleRap.end_event();
   // End of event loop. Statistics. Histogram. Done.
   }
   pythia.stat();
@@ -50,7 +62,7 @@ int main() {
   // normalise the histogram to the number of events
   particleRap /= nEvents;
   ofstream file("main01.out");
-  file << "# Rapidity: cols1,2,3 = bin lo,mid,hi; col4 = nparticles/event" << endl;
+  file << "# Rapidity: cols1,2,3 = bin lo,mid,hi; col4 = nparticles/event, col5 = error" << endl;
   file << particleRap;
   return 0;
 }
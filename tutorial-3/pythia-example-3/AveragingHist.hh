@@ -0,0 +1,171 @@
+#ifndef __AVERAGINGHIST_HH__
+#define __AVERAGINGHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file AveragingHist.hh
+///
+/// AveragingHist is a "profile" histogram: for each bin in x it
+/// accumulates the average of some other quantity y, e.g. the mean
+/// groomed jet mass as a function of jet pt
+///
+/// \code
+///   AveragingHist mmdt_mass_v_pt(500.0, 1500.0, 50.0);
+///   ...
+///   mmdt_mass_v_pt.add_entry(jet.pt(), mmdt_jet.m());
+///   ...
+///   file << mmdt_mass_v_pt;   // binlo binmid binhi average error n
+/// \endcode
+///
+/// Each bin behaves like an AverageAndError, with the same names and
+/// definitions for average(i), sd(i), error(i), etc. The per-bin sums
+/// of y and y^2 and the counts are stored as three separate arrays,
+/// so that merging histograms (e.g. from different threads) and
+/// computing the averages are simple loops over contiguous memory.
+//----------------------------------------------------------------------
+
+#include<valarray>
+#include<cmath>
+#include<iostream>
+#include<cassert>
+#include<cstddef>
+#include<algorithm>
+
+class AveragingHist {
+public:
+  AveragingHist() {};
+
+  AveragingHist(double minv, double maxv, double bin_size) {
+    declare(minv, maxv, bin_size);
+  }
+
+  AveragingHist(double minv, double maxv, unsigned int n) {
+    declare(minv, maxv, n);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, double bin_size) {
+    declare(minv, maxv, unsigned(0.5+(maxv-minv)/bin_size));
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, unsigned int n) {
+    _minv = minv; _maxv = maxv; _dv = (maxv-minv)/n; _inv_dv = 1.0/_dv;
+    _sum.resize(n+1);
+    _sum2.resize(n+1);
+    _n.resize(n+1);
+    reset();
+  }
+
+  /// reset the contents of the histogram to zero (does not
+  /// modify the histogram bounds)
+  void reset() {
+    _sum  = 0.0;
+    _sum2 = 0.0;
+    _n    = 0.0;
+  }
+
+  double min() const {return _minv;};
+  double max() const {return _maxv;};
+  /// returns the size of the histogram proper
+  unsigned int size() const {
+    unsigned outflow_sz = _n.size();
+    assert(outflow_sz > 0); // help capture uninitialised histogram bugs
+    return outflow_sz-1;
+  }
+  /// returns the size of the histogram plus outflow bin
+  unsigned int outflow_size() const {return _n.size();};
+
+  double binlo (int i) const {return i*_dv + _minv;};
+  double binhi (int i) const {return (i+1)*_dv + _minv;};
+  double binmid(int i) const {return (i+0.5)*_dv + _minv;};
+  double binsize()     const {return _dv;};
+
+  unsigned int bin(double x) const {
+    if (x >= _minv && x < _maxv) {
+      unsigned i = unsigned((x-_minv)*_inv_dv);
+      if (i < size()) return i;
+    }
+    return size();
+  }
+
+  /// add the value y in the bin corresponding to x
+  void add_entry(double x, double y) {
+    unsigned i = bin(x);
+    _sum[i]  += y;
+    _sum2[i] += y*y;
+    _n[i]    += 1.0;
+  }
+
+  /// add n entries at once, (x[i], y[i]); the bins are found in a
+  /// first pass over each block and then filled in a second one
+  void add_entries(const double * x, const double * y, std::size_t n) {
+    const std::size_t block = 256;
+    unsigned indices[block];
+    for (std::size_t start = 0; start < n; start += block) {
+      std::size_t nb = std::min(block, n - start);
+      for (std::size_t i = 0; i < nb; i++) indices[i] = bin(x[start+i]);
+      const double * yb = y + start;
+      for (std::size_t i = 0; i < nb; i++) {
+        unsigned ib = indices[i];
+        _sum[ib]  += yb[i];
+        _sum2[ib] += yb[i]*yb[i];
+        _n[ib]    += 1.0;
+      }
+    }
+  }
+
+  /// merge another histogram (e.g. from another thread or job) with
+  /// the same binning into this one
+  AveragingHist & operator+=(const AveragingHist & other) {
+    assert(other.outflow_size() == outflow_size());
+    _sum  += other._sum;
+    _sum2 += other._sum2;
+    _n    += other._n;
+    return *this;
+  }
+
+  /// per-bin quantities, with the same meaning as in AverageAndError
+  double sum (unsigned i) const {return _sum[i];}
+  double sum2(unsigned i) const {return _sum2[i];}
+  double n   (unsigned i) const {return _n[i];}
+  double n_entries(unsigned i) const {return _n[i];}
+
+  /// the average of y in bin i
+  double average(unsigned i) const {return (_n[i] > 0) ? _sum[i]/_n[i] : 0.;}
+  /// the average of y^2 in bin i
+  double average2(unsigned i) const {return (_n[i] > 0) ? _sum2[i]/_n[i] : 0.;}
+  /// the unbiased sample variance of y in bin i
+  double variance(unsigned i) const {
+    return (_n[i] > 1) ? std::abs(_sum2[i] - _sum[i]*_sum[i]/_n[i])/(_n[i]-1) : 0.;
+  }
+  /// the standard deviation of y in bin i
+  double sd(unsigned i) const {return (_n[i] > 1) ? std::sqrt(variance(i)) : 0.;}
+  /// the error on the average of y in bin i (zero for empty bins)
+  double error(unsigned i) const {return (_n[i] > 0) ? sd(i)/std::sqrt(_n[i]) : 0.;}
+
+private:
+  double _minv, _maxv, _dv, _inv_dv;
+  std::valarray<double> _sum, _sum2, _n;
+};
+
+
+/// output the histogram, with columns binlo, binmid, binhi, average,
+/// error on the average and number of entries
+inline void output(const AveragingHist & hist,
+                   std::ostream * ostr = (&std::cout)) {
+  for (unsigned i = 0; i < hist.size(); i++) {
+    *ostr << hist.binlo(i)   << " "
+          << hist.binmid(i)  << " "
+          << hist.binhi(i)   << " "
+          << hist.average(i) << " "
+          << hist.error(i)   << " "
+          << hist.n(i)       << std::endl;
+  }
+}
+
+inline std::ostream & operator<<(std::ostream & ostr, const AveragingHist & hist) {
+  output(hist, &ostr);
+  return ostr;
+}
+
+#endif // __AVERAGINGHIST_HH__
@@ -0,0 +1,170 @@
+#ifndef __COUNTHIST_HH__
+#define __COUNTHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file CountHist.hh
+///
+/// CountHist is a histogram for unweighted fills (the usual case in
+/// the tutorials), with the same binning conventions as SimpleHist,
+/// that stores integer counts rather than doubles:
+///
+/// \code
+///   CountHist jet_mass(0.0, 150.0, 2.0);
+///   ...
+///   jet_mass.add_entry(jets[i].m());
+///   ...
+///   file << SimpleHist(jet_mass) << endl;   // or jet_mass/nEvents, etc.
+/// \endcode
+///
+/// The counts are held in 32-bit integers (half the memory of a
+/// SimpleHist), and the whole histogram is switched to 64-bit counts
+/// the first time any bin would overflow. Filling involves no
+/// multiplications by a weight.
+///
+/// A CountHist is a SimpleHist expression (see SimpleHist.hh): it can
+/// be used to construct or be assigned to a SimpleHist, added to one,
+/// or appear in any histogram arithmetic, in which case its counts
+/// are converted to doubles.
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<vector>
+#include<cassert>
+#include<stdint.h>
+
+class CountHist : public SimpleHistExpr<CountHist> {
+public:
+  CountHist() {};
+
+  CountHist(double minv, double maxv, double bin_size) {
+    declare(minv, maxv, bin_size);
+  }
+
+  CountHist(double minv, double maxv, int n) {
+    declare(minv, maxv, n);
+  }
+
+  CountHist(double minv, double maxv, unsigned int n) {
+    declare(minv, maxv, n);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, double bin_size) {
+    declare(minv, maxv, unsigned(0.5+(maxv-minv)/bin_size));
+  }
+
+  void declare(double minv, double maxv, int n) {
+    declare(minv, maxv, unsigned(n));
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, unsigned int n) {
+    _minv = minv; _maxv = maxv; _n = n; _dv = (maxv-minv)/n;
+    _inv_dv = 1.0/_dv;
+    reset();
+  }
+
+  /// reset the contents of the histogram to zero (and go back to
+  /// 32-bit counts)
+  void reset() {
+    _wide = false;
+    _counts32.assign(_n+1, 0);
+    _counts64.clear();
+    _sum_v = 0.0;
+    _sum_vsq = 0.0;
+  }
+
+  double min() const {return _minv;};
+  double max() const {return _maxv;};
+  /// returns the size of the histogram proper
+  unsigned int size() const {return _n;}
+  /// returns the size of the histogram plus outflow bin
+  unsigned int outflow_size() const {return _n+1;}
+  /// true if the counts have been promoted to 64 bits
+  bool wide() const {return _wide;}
+
+  /// the count in bin i (i = size() is the outflow bin)
+  uint64_t count(unsigned i) const {return _wide ? _counts64[i] : _counts32[i];}
+  /// the count in bin i, as a double
+  double operator[](unsigned i) const {return double(count(i));}
+
+  double binlo (int i) const {return i*_dv + _minv;};
+  double binhi (int i) const {return (i+1)*_dv + _minv;};
+  double binmid(int i) const {return (i+0.5)*_dv + _minv;};
+  double binsize()     const {return _dv;};
+
+  unsigned int bin(double v) const {
+    if (v >= _minv && v < _maxv) {
+      unsigned i = unsigned((v-_minv)*_inv_dv);
+      if (i < _n) return i;
+    }
+    return _n;
+  }
+
+  void add_entry(double v) {
+    unsigned i = bin(v);
+    if (_wide) {
+      _counts64[i]++;
+    } else if (++_counts32[i] == 0) {
+      // the bin has just wrapped round
+      _promote();
+      _counts64[i] = uint64_t(1) << 32;
+    }
+    _sum_v   += v;
+    _sum_vsq += v*v;
+  }
+
+  /// the number of entries, which is also the total weight
+  double n_entries() const {
+    uint64_t total = 0;
+    for (unsigned i = 0; i <= _n; i++) total += count(i);
+    return double(total);
+  }
+  double total_weight() const {return n_entries();}
+  double weight_v()   const {return _sum_v;}
+  double weight_vsq() const {return _sum_vsq;}
+  double mean() const {return _sum_v / n_entries();}
+
+  /// merge the counts from another CountHist with the same binning
+  CountHist & operator+=(const CountHist & other) {
+    assert(other._n == _n && other._minv == _minv && other._maxv == _maxv);
+    if (other._wide && !_wide) _promote();
+    if (_wide) {
+      for (unsigned i = 0; i <= _n; i++) _counts64[i] += other.count(i);
+    } else {
+      for (unsigned i = 0; i <= _n; i++) {
+        uint32_t sum = _counts32[i] + other._counts32[i];
+        if (sum < _counts32[i]) {
+          // overflow: redo this and remaining bins in 64 bits
+          _promote();
+          for (unsigned j = i; j <= _n; j++) _counts64[j] += other.count(j);
+          break;
+        }
+        _counts32[i] = sum;
+      }
+    }
+    _sum_v   += other._sum_v;
+    _sum_vsq += other._sum_vsq;
+    return *this;
+  }
+
+private:
+  /// switch to 64-bit counts
+  void _promote() {
+    _counts64.assign(_counts32.begin(), _counts32.end());
+    std::vector<uint32_t>().swap(_counts32);
+    _wide = true;
+  }
+
+  double _minv, _maxv, _dv, _inv_dv;
+  unsigned int _n;
+  bool _wide;
+  std::vector<uint32_t> _counts32;
+  std::vector<uint64_t> _counts64;
+  double _sum_v, _sum_vsq;
+};
+
+/// CountHists are held by reference in histogram expressions
+template<> struct SimpleHistOperand<CountHist> {typedef const CountHist & stored_type;};
+
+#endif // __COUNTHIST_HH__
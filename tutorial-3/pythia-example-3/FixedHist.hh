@@ -0,0 +1,152 @@
+#ifndef __FIXEDHIST_HH__
+#define __FIXEDHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file FixedHist.hh
+///
+/// FixedHist<N, Lo, Hi, Den> is a histogram whose binning is fixed at
+/// compile time: N bins between Lo/Den and Hi/Den (the limits are
+/// given as integers, since C++ does not allow floating-point template
+/// arguments). E.g. the equivalents of
+///
+/// \code
+///   SimpleHist jet_mass(0.0, 150.0, 2.0);
+///   SimpleHist jet_multiplicity(-0.5, 12.5, 1.0);
+/// \endcode
+///
+/// are
+///
+/// \code
+///   FixedHist<75, 0, 150>     jet_mass;
+///   FixedHist<13, -1, 25, 2>  jet_multiplicity;
+/// \endcode
+///
+/// The bins (including the outflow bin) are stored inside the object,
+/// and finding the bin for a value is a multiplication by a constant,
+/// a range check and a conversion to an integer.
+///
+/// A FixedHist can be used wherever a histogram expression is allowed
+/// (e.g. in arithmetic with SimpleHists, see SimpleHist.hh), and can be
+/// assigned to or used to construct a SimpleHist; it has the same
+/// output format.
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<iostream>
+#include<cassert>
+
+template<unsigned N, long Lo, long Hi, long Den = 1>
+class FixedHist : public SimpleHistExpr<FixedHist<N,Lo,Hi,Den> > {
+public:
+  FixedHist() {reset();}
+
+  /// reset the contents of the histogram to zero
+  void reset() {
+    for (unsigned i = 0; i <= N; i++) _weights[i] = 0.0;
+    _weight_v = 0.0;
+    _weight_vsq = 0.0;
+    _n_entries = 0.0;
+  }
+
+  static constexpr double min() {return double(Lo)/Den;}
+  static constexpr double max() {return double(Hi)/Den;}
+  static constexpr double binsize() {return (max()-min())/N;}
+  /// returns the size of the histogram proper
+  static constexpr unsigned int size() {return N;}
+  /// returns the size of the histogram plus outflow bin
+  static constexpr unsigned int outflow_size() {return N+1;}
+
+  double & operator[](int i) {return _weights[i];};
+  const double & operator[](int i) const {return _weights[i];};
+
+  /// returns the outflow bin
+  double & outflow() {return _weights[N];};
+  const double & outflow() const {return _weights[N];};
+
+  double binlo (int i) const {return i*binsize() + min();};
+  double binhi (int i) const {return (i+1)*binsize() + min();};
+  double binmid(int i) const {return (i+0.5)*binsize() + min();};
+
+  static unsigned int bin(double v) {
+    double x = (v - min()) * _inv_dv();
+    // NB: this also sends NaNs to the outflow bin
+    return (x >= 0.0 && x < N) ? unsigned(x) : N;
+  }
+
+  void add_entry(double v, double weight = 1.0) {
+    _weights[bin(v)] += weight;
+    _weight_v += weight * v;
+    _weight_vsq += weight * v * v;
+    _n_entries += 1.0;
+  }
+
+  double n_entries()  const {return _n_entries;}
+  double weight_v()   const {return _weight_v;}
+  double weight_vsq() const {return _weight_vsq;}
+
+  /// return the total weight in the histogram, including outflow
+  double total_weight() const {
+    double total = 0.0;
+    for (unsigned i = 0; i <= N; i++) total += _weights[i];
+    return total;
+  }
+  /// return the mean value of all entries
+  double mean() const {return _weight_v / total_weight();}
+
+  // Operations with constants ---------------------------------------
+  FixedHist & operator*=(double fact) {
+    for (unsigned i = 0; i <= N; i++) _weights[i] *= fact;
+    _weight_v *= fact;
+    _weight_vsq *= fact;
+    return *this;
+  }
+  FixedHist & operator/=(double fact) {return *this *= 1.0/fact;}
+
+  // Operations with another histogram (or histogram expression) ------
+  template<class E> FixedHist & operator+=(const SimpleHistExpr<E> & expr) {
+    const E & e = expr.self();
+    assert(e.outflow_size() == N+1);
+    for (unsigned i = 0; i <= N; i++) _weights[i] += e[i];
+    _weight_v += e.weight_v();
+    _weight_vsq += e.weight_vsq();
+    _n_entries += e.n_entries();
+    return *this;
+  }
+
+  template<class E> FixedHist & operator-=(const SimpleHistExpr<E> & expr) {
+    const E & e = expr.self();
+    assert(e.outflow_size() == N+1);
+    for (unsigned i = 0; i <= N; i++) _weights[i] -= e[i];
+    _weight_v -= e.weight_v();
+    _weight_vsq -= e.weight_vsq();
+    _n_entries += e.n_entries();
+    return *this;
+  }
+
+private:
+  static constexpr double _inv_dv() {return N/(max()-min());}
+
+  double _weights[N+1];
+  double _weight_v, _weight_vsq;
+  double _n_entries;
+};
+
+/// FixedHists are held by reference in histogram expressions
+template<unsigned N, long Lo, long Hi, long Den>
+struct SimpleHistOperand<FixedHist<N,Lo,Hi,Den> > {
+  typedef const FixedHist<N,Lo,Hi,Den> & stored_type;
+};
+
+/// output the histogram, in the same format as a SimpleHist
+template<unsigned N, long Lo, long Hi, long Den>
+inline std::ostream & operator<<(std::ostream & ostr, const FixedHist<N,Lo,Hi,Den> & hist) {
+  for (unsigned i = 0; i < N; i++) {
+    ostr << hist.binlo(i)  << " "
+         << hist.binmid(i) << " "
+         << hist.binhi(i)  << " "
+         << hist[i] << std::endl;
+  }
+  return ostr;
+}
+
+#endif // __FIXEDHIST_HH__
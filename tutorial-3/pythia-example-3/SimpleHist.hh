@@ -32,9 +32,49 @@
 #include<cmath>
 #include<iostream>
 #include<cassert>
+#include<cstdlib>
 #include<vector>
 
-class SimpleHist {
+//----------------------------------------------------------------------
+// Expression templates: arithmetic on histograms (hist*hist, hist+hist,
+// hist*constant, sqrt(hist), etc.) does not create intermediate
+// histograms, but rather a lightweight "expression" object that
+// refers to its operands. The expression is only evaluated when it is
+// assigned to (or used to construct) a SimpleHist, in a single loop
+// over the bins. So e.g.
+//
+//   SimpleHist err = sqrt(pow2(a) + pow2(b))/n;
+//
+// allocates just the result. NB: expressions hold references to
+// their SimpleHist operands, so they should not be stored (e.g. with
+// "auto"), only assigned to a SimpleHist.
+//
+// Each expression also provides the weighted moments of v
+// (weight_v(), weight_vsq()) and n_entries() for its result:
+//   - for sums and differences of histograms, and multiplication or
+//     division by a constant, these are combined in the same way as
+//     the bins (n_entries is summed for sums and differences, and
+//     left unchanged by a constant);
+//   - for products and ratios of histograms, for a constant divided
+//     by a histogram and for the unary functions, they are those of
+//     the first histogram operand, as for the corresponding compound
+//     assignment operators (*=, /=).
+//----------------------------------------------------------------------
+
+class SimpleHist;
+
+/// base class for all histogram expressions, E being the derived class
+template<class E> class SimpleHistExpr {
+public:
+  const E & self() const {return static_cast<const E &>(*this);}
+};
+
+/// the way an operand of type E is held in an expression: 
+/// expressions by value (they are small), histograms by reference
+template<class E> struct SimpleHistOperand {typedef const E stored_type;};
+template<> struct SimpleHistOperand<SimpleHist> {typedef const SimpleHist & stored_type;};
+
+class SimpleHist : public SimpleHistExpr<SimpleHist> {
 public:
   SimpleHist() {};
   SimpleHist(double minv, double maxv, int n): 
@@ -42,7 +82,7 @@ public:
     _weights = 0.0;
     _weight_v = 0.0;
     _weight_vsq = 0.0;
-    _have_total = false;
+    _total_weight = 0.0;
     _n_entries = 0.0;
   }
 
@@ -54,6 +94,34 @@ public:
     declare(minv, maxv, int(0.5+(maxv-minv)/bin_size));
   }
 
+  /// construct the histogram from the result of a histogram expression
+  template<class E> SimpleHist(const SimpleHistExpr<E> & expr) {
+    *this = expr;
+  }
+
+  /// evaluate a histogram expression (in a single loop over the bins)
+  /// into this histogram, which takes on the expression's binning
+  template<class E> SimpleHist & operator=(const SimpleHistExpr<E> & expr) {
+    const E & e = expr.self();
+    // get everything from the expression before writing anything,
+    // since this histogram may be one of its operands
+    double   minv = e.min(), maxv = e.max();
+    unsigned n    = e.size();
+    double   weight_v = e.weight_v(), weight_vsq = e.weight_vsq();
+    double   n_entries = e.n_entries();
+    if (_weights.size() != n+1) _weights.resize(n+1);
+    double total_weight = 0.0;
+    for (unsigned i = 0; i <= n; i++) {
+      _weights[i] = e[i];
+      total_weight += _weights[i];
+    }
+    _minv = minv; _maxv = maxv; _dv = (maxv-minv)/n;
+    _weight_v = weight_v; _weight_vsq = weight_vsq;
+    _total_weight = total_weight;
+    _n_entries = n_entries;
+    return *this;
+  }
+
   // declare (or redeclare) the histogram
   void declare(double minv, double maxv, double bin_size) {
     declare(minv, maxv, int(0.5+(maxv-minv)/bin_size));
@@ -77,7 +145,6 @@ public:
     _weight_v = 0.0;
     _weight_vsq = 0.0;
     _total_weight = 0.0;
-    _have_total = false;
     _n_entries = 0.0;
   }
 
@@ -92,11 +159,20 @@ public:
   /// returns the size of the histogram plus outflow bin
   unsigned int outflow_size() const {return _weights.size();};
 
-  double & operator[](int i) {_have_total = false; return _weights[i];};
   const double & operator[](int i) const {return _weights[i];};
+
+  /// set the contents of bin i to w (i = size() is the outflow bin)
+  void set(unsigned i, double w) {
+    _total_weight += w - _weights[i];
+    _weights[i] = w;
+  }
+  /// add w to the contents of bin i (i = size() is the outflow bin)
+  void add(unsigned i, double w) {
+    _total_weight += w;
+    _weights[i] += w;
+  }
   
   /// returns the outflow bin
-  double & outflow() {return _weights[size()];};
   const double & outflow() const {return _weights[size()];};
 
   double binlo (int i) const {return i*_dv + _minv;};
@@ -120,36 +196,95 @@ public:
 
   /// return the mean value of all events given to histogram
   /// including those that were outside the histogram edges
-  double mean() const {return _weight_v / total_weight();}
-
-  /// return the total weight in the histogram (inefficient)...
-  double total_weight() const {
-    if (!_have_total) {
-      _total_weight = 0.0;
-      for (unsigned i = 0; i < _weights.size(); i++) {
-        _total_weight += _weights[i];}
-      _have_total = true;
-    }
-    return _total_weight;
+  double mean() const {return _weight_v / _total_weight;}
+
+  /// return the (weighted) variance of the values of all events given
+  /// to the histogram, including those outside the histogram edges
+  double variance() const {
+    double m = mean();
+    return _weight_vsq / _total_weight - m*m;
   }
 
+  /// return the total weight in the histogram, including the outflow
+  /// bin (this is kept up to date as the histogram is filled)
+  double total_weight() const {return _total_weight;}
+
   double n_entries() const {return _n_entries;}
 
+  /// return the sum of weight*v (and weight*v*v) over all entries,
+  /// including those outside the histogram edges
+  double weight_v()   const {return _weight_v;}
+  double weight_vsq() const {return _weight_vsq;}
+
+  /// set the moments, total weight and number of entries, for a
+  /// histogram whose bins have been set from some other
+  /// representation (e.g. a projection of a 2D histogram), so that
+  /// mean(), variance() and n_entries() refer to the original entries
+  void set_moments(double weight_v, double weight_vsq,
+                   double total_weight, double n_entries) {
+    _weight_v     = weight_v;
+    _weight_vsq   = weight_vsq;
+    _total_weight = total_weight;
+    _n_entries    = n_entries;
+  }
+
   void add_entry(double v, double weight = 1.0) {
     //if (v >= _minv && v < _maxv) {
     //  int i = int((v-_minv)/_dv); 
     //  if (i >= 0 && i < int(_weights.size())) _weights[i] += weight;
     //}
-    _have_total = false;
     _weights[bin(v)] += weight;
+    _total_weight += weight;
     _weight_v += weight * v;
     _weight_vsq += weight * v * v;
     _n_entries += 1.0;
   };
 
+  /// return a coarser version of this histogram, with bins from minv
+  /// to maxv of size bin_size; the new bin edges must coincide with
+  /// edges of this histogram. Bins that fall outside the new range go
+  /// into the new outflow bin, and the moments, total weight and
+  /// number of entries are unchanged.
+  SimpleHist rebinned(double minv, double maxv, double bin_size) const {
+    SimpleHist result(minv, maxv, bin_size);
+    // check that the new edges line up with ours
+    assert(std::abs((minv - _minv)/_dv - std::floor((minv - _minv)/_dv + 0.5)) < 1e-6);
+    assert(std::abs(result._dv/_dv - std::floor(result._dv/_dv + 0.5)) < 1e-6);
+    for (unsigned i = 0; i < size(); i++) {
+      result._weights[result.bin(binmid(i))] += _weights[i];
+    }
+    result._weights[result.size()] += _weights[size()];
+    result._weight_v     = _weight_v;
+    result._weight_vsq   = _weight_vsq;
+    result._total_weight = _total_weight;
+    result._n_entries    = _n_entries;
+    return result;
+  }
+
+  /// return a version of this histogram in which each group of factor
+  /// consecutive bins has been merged into one (0 < factor <= size(),
+  /// otherwise the program exits with an error). If the number of bins
+  /// is not a multiple of factor, the new histogram stops at the last
+  /// complete group, and the left-over bins at the top go into the
+  /// outflow bin (with a warning).
+  SimpleHist rebinned(unsigned int factor) const {
+    if (factor == 0 || factor > size()) {
+      std::cerr << "SimpleHist::rebinned: factor " << factor << " should be between 1 and "
+                << size() << " (the number of bins)" << std::endl;
+      exit(-1);
+    }
+    unsigned n = size()/factor;
+    if (n*factor != size()) {
+      std::cerr << "SimpleHist::rebinned: warning, " << size() << " bins is not a multiple of "
+                << factor << "; the top " << size() - n*factor
+                << " bins go into the outflow bin" << std::endl;
+    }
+    return rebinned(_minv, _minv + n*factor*_dv, factor*_dv);
+  }
+
   // Operations with constants ---------------------------------------
   SimpleHist & operator*=(double fact) {
-    for (unsigned i = 0; i < outflow_size(); i++) (*this)[i] *= fact;
+    for (unsigned i = 0; i < outflow_size(); i++) _weights[i] *= fact;
     _weight_v *= fact;
     _weight_vsq *= fact;
     _total_weight *= fact;
@@ -163,114 +298,253 @@ public:
   // Operations with another histogram -------------------------------
   SimpleHist & operator*=(const SimpleHist & other) {
     assert(other.outflow_size() == outflow_size());
-    for (unsigned i = 0; i < outflow_size(); i++) (*this)[i] *= other[i];
+    _total_weight = 0.0;
+    for (unsigned i = 0; i < outflow_size(); i++) {
+      _weights[i] *= other[i];
+      _total_weight += _weights[i];
+    }
     return *this;
   };
 
   SimpleHist & operator/=(const SimpleHist & other) {
     assert(other.outflow_size() == outflow_size());
-    for (unsigned i = 0; i < outflow_size(); i++) (*this)[i] /= other[i];
+    _total_weight = 0.0;
+    for (unsigned i = 0; i < outflow_size(); i++) {
+      _weights[i] /= other[i];
+      _total_weight += _weights[i];
+    }
     return *this;
   };
 
   SimpleHist & operator+=(const SimpleHist & other) {
     assert(other.outflow_size() == outflow_size());
-    for (unsigned i = 0; i < outflow_size(); i++) (*this)[i] += other[i];
+    for (unsigned i = 0; i < outflow_size(); i++) _weights[i] += other[i];
     _weight_v += other._weight_v;
     _weight_vsq += other._weight_vsq;
-    if (_have_total && other._have_total) {
-      _total_weight += other._total_weight;
-    } else {_have_total = false;}
+    _total_weight += other._total_weight;
+    _n_entries += other._n_entries;
     return *this;
   };
 
   SimpleHist & operator-=(const SimpleHist & other) {
     assert(other.outflow_size() == outflow_size());
-    for (unsigned i = 0; i < outflow_size(); i++) (*this)[i] -= other[i];
+    for (unsigned i = 0; i < outflow_size(); i++) _weights[i] -= other[i];
+    _weight_v -= other._weight_v;
+    _weight_vsq -= other._weight_vsq;
+    _total_weight -= other._total_weight;
+    _n_entries += other._n_entries;
     return *this;
   };
 
+  // Operations with a histogram expression --------------------------
+  template<class E> SimpleHist & operator+=(const SimpleHistExpr<E> & expr) {
+    const E & e = expr.self();
+    assert(e.outflow_size() == outflow_size());
+    for (unsigned i = 0; i < outflow_size(); i++) {
+      double w = e[i];
+      _weights[i] += w;
+      _total_weight += w;
+    }
+    _weight_v += e.weight_v();
+    _weight_vsq += e.weight_vsq();
+    _n_entries += e.n_entries();
+    return *this;
+  }
+
+  template<class E> SimpleHist & operator-=(const SimpleHistExpr<E> & expr) {
+    const E & e = expr.self();
+    assert(e.outflow_size() == outflow_size());
+    for (unsigned i = 0; i < outflow_size(); i++) {
+      double w = e[i];
+      _weights[i] -= w;
+      _total_weight -= w;
+    }
+    _weight_v -= e.weight_v();
+    _weight_vsq -= e.weight_vsq();
+    _n_entries += e.n_entries();
+    return *this;
+  }
 
-  friend SimpleHist operator*(const SimpleHist & hist, double fact);
-  friend SimpleHist operator/(const SimpleHist & hist, double fact);
+  template<class E> SimpleHist & operator*=(const SimpleHistExpr<E> & expr) {
+    const E & e = expr.self();
+    assert(e.outflow_size() == outflow_size());
+    _total_weight = 0.0;
+    for (unsigned i = 0; i < outflow_size(); i++) {
+      _weights[i] *= e[i];
+      _total_weight += _weights[i];
+    }
+    return *this;
+  }
+
+  template<class E> SimpleHist & operator/=(const SimpleHistExpr<E> & expr) {
+    const E & e = expr.self();
+    assert(e.outflow_size() == outflow_size());
+    _total_weight = 0.0;
+    for (unsigned i = 0; i < outflow_size(); i++) {
+      _weights[i] /= e[i];
+      _total_weight += _weights[i];
+    }
+    return *this;
+  }
 
 private:
   double _minv, _maxv, _dv;
   std::valarray<double> _weights;
   std::string _name;
   double _weight_v, _weight_vsq;
-  mutable double _total_weight;
-  mutable bool   _have_total;
+  double _total_weight;
   double _n_entries;
 };
 
 
 
+//----------------------------------------------------------------------
+/// expression for the bin-by-bin combination of two histogram
+/// expressions, with Op providing the operation on the bins and the
+/// moments
+template<class A, class B, class Op>
+class SimpleHistBinaryExpr : public SimpleHistExpr<SimpleHistBinaryExpr<A,B,Op> > {
+public:
+  SimpleHistBinaryExpr(const A & a, const B & b) : _a(a), _b(b) {
+    assert(a.outflow_size() == b.outflow_size());
+  }
+  double operator[](unsigned i) const {return Op::apply(_a[i], _b[i]);}
+  double min() const {return _a.min();}
+  double max() const {return _a.max();}
+  unsigned int size() const {return _a.size();}
+  unsigned int outflow_size() const {return _a.outflow_size();}
+  double weight_v()   const {return Op::moment(_a.weight_v(),   _b.weight_v());}
+  double weight_vsq() const {return Op::moment(_a.weight_vsq(), _b.weight_vsq());}
+  double n_entries()  const {return Op::entries(_a.n_entries(), _b.n_entries());}
+private:
+  typename SimpleHistOperand<A>::stored_type _a;
+  typename SimpleHistOperand<B>::stored_type _b;
+};
+
+/// expression for the bin-by-bin combination of a histogram
+/// expression with a constant
+template<class A, class Op>
+class SimpleHistScalarExpr : public SimpleHistExpr<SimpleHistScalarExpr<A,Op> > {
+public:
+  SimpleHistScalarExpr(const A & a, double fact) : _a(a), _fact(fact) {}
+  double operator[](unsigned i) const {return Op::apply(_a[i], _fact);}
+  double min() const {return _a.min();}
+  double max() const {return _a.max();}
+  unsigned int size() const {return _a.size();}
+  unsigned int outflow_size() const {return _a.outflow_size();}
+  double weight_v()   const {return Op::scalar_moment(_a.weight_v(),   _fact);}
+  double weight_vsq() const {return Op::scalar_moment(_a.weight_vsq(), _fact);}
+  double n_entries()  const {return _a.n_entries();}
+private:
+  typename SimpleHistOperand<A>::stored_type _a;
+  double _fact;
+};
+
+/// expression for a function applied to each bin of a histogram
+/// expression
+template<class A, class Op>
+class SimpleHistUnaryExpr : public SimpleHistExpr<SimpleHistUnaryExpr<A,Op> > {
+public:
+  SimpleHistUnaryExpr(const A & a) : _a(a) {}
+  double operator[](unsigned i) const {return Op::apply(_a[i]);}
+  double min() const {return _a.min();}
+  double max() const {return _a.max();}
+  unsigned int size() const {return _a.size();}
+  unsigned int outflow_size() const {return _a.outflow_size();}
+  double weight_v()   const {return _a.weight_v();}
+  double weight_vsq() const {return _a.weight_vsq();}
+  double n_entries()  const {return _a.n_entries();}
+private:
+  typename SimpleHistOperand<A>::stored_type _a;
+};
+
+// the operations used in the expressions
+struct SimpleHistOpAdd {
+  static double apply  (double a, double b) {return a + b;}
+  static double moment (double a, double b) {return a + b;}
+  static double entries(double a, double b) {return a + b;}
+};
+struct SimpleHistOpSub {
+  static double apply  (double a, double b) {return a - b;}
+  static double moment (double a, double b) {return a - b;}
+  static double entries(double a, double b) {return a + b;}
+};
+struct SimpleHistOpMul {
+  static double apply  (double a, double b) {return a * b;}
+  static double moment (double a, double  ) {return a;}
+  static double entries(double a, double  ) {return a;}
+  static double scalar_moment(double a, double fact) {return a * fact;}
+};
+struct SimpleHistOpDiv {
+  static double apply  (double a, double b) {return a / b;}
+  static double moment (double a, double  ) {return a;}
+  static double entries(double a, double  ) {return a;}
+  static double scalar_moment(double a, double fact) {return a / fact;}
+};
+/// a constant divided by each bin of a histogram
+struct SimpleHistOpDivScalarLeft {
+  static double apply        (double a, double fact) {return fact / a;}
+  static double scalar_moment(double a, double     ) {return a;}
+};
+struct SimpleHistOpSqrt {
+  static double apply(double a) {return std::sqrt(a);}
+};
+struct SimpleHistOpPow2 {
+  static double apply(double a) {return a*a;}
+};
+
+
 // Binary operations with constants -----------------------------
-inline SimpleHist operator*(const SimpleHist & hist, double fact) {
-  SimpleHist result(hist.min(), hist.max(), hist.outflow_size());
-  for (unsigned i = 0; i < hist.outflow_size(); i++) result[i] = hist[i] * fact;
-  result._weight_v = hist._weight_v * fact;
-  result._weight_vsq = hist._weight_vsq * fact;
-  return result;
+template<class A> inline SimpleHistScalarExpr<A,SimpleHistOpMul>
+operator*(const SimpleHistExpr<A> & hist, double fact) {
+  return SimpleHistScalarExpr<A,SimpleHistOpMul>(hist.self(), fact);
 }
 
-inline SimpleHist operator/(const SimpleHist & hist, double fact) {
-  SimpleHist result(hist.min(), hist.max(), hist.outflow_size());
-  for (unsigned i = 0; i < hist.outflow_size(); i++) result[i] = hist[i] / fact;
-  result._weight_v = hist._weight_v / fact;
-  result._weight_vsq = hist._weight_vsq / fact;
-  return result;
+template<class A> inline SimpleHistScalarExpr<A,SimpleHistOpDiv>
+operator/(const SimpleHistExpr<A> & hist, double fact) {
+  return SimpleHistScalarExpr<A,SimpleHistOpDiv>(hist.self(), fact);
 }
 
-inline SimpleHist operator*(double fact, const SimpleHist & hist) {
+template<class A> inline SimpleHistScalarExpr<A,SimpleHistOpMul>
+operator*(double fact, const SimpleHistExpr<A> & hist) {
   return hist*fact;
 }
 
-inline SimpleHist operator/(double fact, const SimpleHist & hist) {
-  return hist/fact;
+template<class A> inline SimpleHistScalarExpr<A,SimpleHistOpDivScalarLeft>
+operator/(double fact, const SimpleHistExpr<A> & hist) {
+  return SimpleHistScalarExpr<A,SimpleHistOpDivScalarLeft>(hist.self(), fact);
 }
 
 
 // Binary operations with other histograms ------------------------
-inline SimpleHist operator*(const SimpleHist & hista, const SimpleHist & histb) {
-  assert(hista.outflow_size() == histb.outflow_size());
-  SimpleHist result(hista.min(), hista.max(), hista.size());
-  for (unsigned i = 0; i < hista.outflow_size(); i++) result[i] = hista[i] * histb[i];
-  return result;
+template<class A, class B> inline SimpleHistBinaryExpr<A,B,SimpleHistOpMul>
+operator*(const SimpleHistExpr<A> & hista, const SimpleHistExpr<B> & histb) {
+  return SimpleHistBinaryExpr<A,B,SimpleHistOpMul>(hista.self(), histb.self());
 }
-inline SimpleHist operator/(const SimpleHist & hista, const SimpleHist & histb) {
-  assert(hista.outflow_size() == histb.outflow_size());
-  SimpleHist result(hista.min(), hista.max(), hista.size());
-  for (unsigned i = 0; i < hista.outflow_size(); i++) result[i] = hista[i] / histb[i];
-  return result;
+template<class A, class B> inline SimpleHistBinaryExpr<A,B,SimpleHistOpDiv>
+operator/(const SimpleHistExpr<A> & hista, const SimpleHistExpr<B> & histb) {
+  return SimpleHistBinaryExpr<A,B,SimpleHistOpDiv>(hista.self(), histb.self());
 }
-inline SimpleHist operator+(const SimpleHist & hista, const SimpleHist & histb) {
-  assert(hista.outflow_size() == histb.outflow_size());
-  SimpleHist result(hista.min(), hista.max(), hista.size());
-  for (unsigned i = 0; i < hista.outflow_size(); i++) result[i] = hista[i] + histb[i];
-  return result;
+template<class A, class B> inline SimpleHistBinaryExpr<A,B,SimpleHistOpAdd>
+operator+(const SimpleHistExpr<A> & hista, const SimpleHistExpr<B> & histb) {
+  return SimpleHistBinaryExpr<A,B,SimpleHistOpAdd>(hista.self(), histb.self());
 }
-inline SimpleHist operator-(const SimpleHist & hista, const SimpleHist & histb) {
-  assert(hista.outflow_size() == histb.outflow_size());
-  SimpleHist result(hista.min(), hista.max(), hista.size());
-  for (unsigned i = 0; i < hista.outflow_size(); i++) result[i] = hista[i] - histb[i];
-  return result;
+template<class A, class B> inline SimpleHistBinaryExpr<A,B,SimpleHistOpSub>
+operator-(const SimpleHistExpr<A> & hista, const SimpleHistExpr<B> & histb) {
+  return SimpleHistBinaryExpr<A,B,SimpleHistOpSub>(hista.self(), histb.self());
 }
 
 
 // Unary mathematical functions
-inline SimpleHist sqrt(const SimpleHist & hist) {
-  SimpleHist result(hist.min(), hist.max(), hist.size());
-  for (unsigned i = 0; i < hist.outflow_size(); i++) result[i] = sqrt(hist[i]);
-  return result;
+template<class A> inline SimpleHistUnaryExpr<A,SimpleHistOpSqrt>
+sqrt(const SimpleHistExpr<A> & hist) {
+  return SimpleHistUnaryExpr<A,SimpleHistOpSqrt>(hist.self());
 }
 
 // Unary mathematical functions
-inline SimpleHist pow2(const SimpleHist & hist) {
-  SimpleHist result(hist.min(), hist.max(), hist.size());
-  for (unsigned i = 0; i < hist.outflow_size(); i++) result[i] = hist[i]*hist[i];
-  return result;
+template<class A> inline SimpleHistUnaryExpr<A,SimpleHistOpPow2>
+pow2(const SimpleHistExpr<A> & hist) {
+  return SimpleHistUnaryExpr<A,SimpleHistOpPow2>(hist.self());
 }
 
 /// output the histogram to standard output -- an operator<< might
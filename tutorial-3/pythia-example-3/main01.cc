@@ -11,7 +11,11 @@
 #include "Pythia8/FJcore.h"  // subset of FastJet clustering
 #include "helpers.hh"
 #include "AverageAndError.hh"
+#include "QuantileSketch.hh"
 #include "SimpleHist.hh"
+#include "FixedHist.hh"
+#include "CountHist.hh"
+#include "AveragingHist.hh"
 #include "CmdLine.hh"
 
 using namespace Pythia8;
@@ -27,7 +31,26 @@ int main(int argc, char ** argv) {
   double Q    = cmdline.value("-Q", 100.0);
   double ycut = cmdline.value("-ycut", 0.03);
   int nEvents = int(cmdline.value("-nev", 1000.0));
+  // optionally, stop before nEvents once the quantity named by -target
+  // ("multiplicity" for the average multiplicity, or "njets=N" for
+  // the fraction of events with N jets) has a relative error below
+  // -precision; this is checked every check_every events
+  string target      = cmdline.value<string>("-target", "");
+  double precision   = cmdline.value("-precision", 0.01);
+  int    check_every = cmdline.value("-check-every", 1000);
   cmdline.assert_all_options_used();
+
+  int target_njets = -1;
+  if (target.compare(0, 6, "njets=") == 0) {
+    target_njets = atoi(target.c_str()+6);
+  } else if (target != "" && target != "multiplicity") {
+    cerr << "Unrecognised -target " << target << " (should be multiplicity or njets=N)" << endl;
+    exit(-1);
+  }
+  if (check_every <= 0) {
+    cerr << "-check-every must be positive (got " << check_every << ")" << endl;
+    exit(-1);
+  }
   
   // Generator. Process selection. LHC initialization. Histogram.
   Pythia pythia;
@@ -57,14 +80,49 @@ int main(int argc, char ** argv) {
 
   // for getting the average across events
   AverageAndError multiplicity;
-  // for storing the different jet rates
-  SimpleHist jet_rates(1.5, 5.5, 1.0);
+  // and for its quantiles
+  QuantileSketch multiplicity_quantiles;
+  // and for its full distribution (unweighted, so stored as integer
+  // counts)
+  CountHist multiplicity_dist(-0.5, 299.5, 1.0);
+  // for storing the different jet rates: 4 bins from 3/2 to 11/2,
+  // with the binning fixed at compile time
+  FixedHist<4, 3, 11, 2> jet_rates;
+  if (target_njets >= 0 && (target_njets < jet_rates.min() || target_njets > jet_rates.max())) {
+    cerr << "-target njets=N needs N within the jet-rate histogram, "
+         << jet_rates.min() << " < N < " << jet_rates.max() << " (got " << target_njets << ")" << endl;
+    exit(-1);
+  }
+  // for the average multiplicity as a function of the number of jets
+  AveragingHist multiplicity_v_njets(-0.5, 10.5, 1.0);
   
   
+  // the number of events that were generated successfully
+  int nAccepted = 0;
+  // the relative error on the target so far
+  auto relative_error = [&]() {
+    if (target_njets >= 0) {
+      // binomial error on the fraction of events with target_njets jets
+      if (nAccepted == 0) return 1.0;
+      double f = jet_rates[jet_rates.bin(target_njets)] / nAccepted;
+      return (f > 0) ? sqrt(f*(1-f)/nAccepted)/f : 1.0;
+    } else {
+      return multiplicity.error()/multiplicity.average();
+    }
+  };
+
   // Begin event loop. Generate event. Skip if error. List first one.
   for (int iEvent = 0; iEvent < nEvents; ++iEvent) {
+
+    // check whether the target precision has been reached
+    if (target != "" && iEvent > 0 && iEvent % check_every == 0
+        && relative_error() < precision) {
+      nEvents = iEvent;
+      break;
+    }
     
     if (!pythia.next()) continue;
+    nAccepted++;
 
     vector<PseudoJet> particles;
     
@@ -79,6 +137,8 @@ int main(int argc, char ** argv) {
 
     // this keeps track of the multiplicity (of the special AverageAndError type)
     multiplicity += particles.size();
+    multiplicity_quantiles += particles.size();
+    multiplicity_dist.add_entry(particles.size());
     
     // Cluster particle into jets
     // First generate a whole "clustering sequence" with the e+e- kt algorithm
@@ -91,6 +151,7 @@ int main(int argc, char ** argv) {
 
     // record the number of jets
     jet_rates.add_entry(jets.size());
+    multiplicity_v_njets.add_entry(jets.size(), particles.size());
       
   // End of event loop. Statistics. Histogram. Done.
   }
@@ -104,13 +165,25 @@ int main(int argc, char ** argv) {
   ofstream file(filename_stream.str());
   file << "# " << cmdline.command_line() << endl;
   file << "# Q = " << Q << endl;
+  file << "# nEvents = " << nEvents << ", of which accepted = " << nAccepted << endl;
+  if (target != "") file << "# relative error on " << target << " = " << relative_error()
+                         << " (target " << precision << ")" << endl;
   file << "# <multiplicity> = " << multiplicity.average() << " +- " << multiplicity.error() << endl;
   file << "# <multiplicity^2> - <multiplicity>^2 = " << multiplicity.sd() << endl;
+  file << "# multiplicity quantiles: p50 = " << multiplicity_quantiles.quantile(0.50)
+       << ", p90 = " << multiplicity_quantiles.quantile(0.90)
+       << ", p99 = " << multiplicity_quantiles.quantile(0.99) << endl;
   file << endl;
 
   file << "# Histogram of fraction of events with n jets (col4) v. n (col2)" << endl;
   jet_rates /= nEvents;
-  file << jet_rates << endl;
+  file << jet_rates << endl << endl;
+
+  file << "# Histogram of fraction of events (col4) v. multiplicity (col2)" << endl;
+  file << SimpleHist(multiplicity_dist / double(nEvents)) << endl << endl;
+
+  file << "# Average multiplicity (col4, error col5, nevents col6) v. n jets (col2)" << endl;
+  file << multiplicity_v_njets << endl;
   
   
   return 0;
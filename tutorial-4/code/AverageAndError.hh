@@ -3,73 +3,143 @@
 
 #include<cmath>
 #include<vector>
+#include<cstddef>
+#include<stdint.h>
 
 /// micro class to calculate averages and errors
+///
+/// Internally it keeps the mean and the sums of the 2nd, 3rd and 4th
+/// powers of the deviations from the mean (rather than raw power
+/// sums, which suffer from large cancellations), updated with the
+/// one-pass formulas of Welford and Pébay. Two accumulators (e.g. from
+/// different threads or jobs) can be merged exactly with +=.
 class AverageAndError {
 public:
 
   /// default constructor
-  AverageAndError() { _sum = 0.0; _sum2 = 0.0; _sum3 = 0.0; _sum4 = 0.0; _n=0;}
-  
+  AverageAndError() { _n = 0; _mean = 0.0; _m2 = 0.0; _m3 = 0.0; _m4 = 0.0;}
+
   /// add one entry
-  inline void add(double x) { _sum += x;
-                              double x2 = x*x; 
-                              _sum2 += x2;
-                              _sum3 += x2*x;
-                              _sum4 += x2*x2;
+  inline void add(double x) { int64_t n1 = _n;
                               _n += 1;
+                              double n = _n;
+                              double delta = x - _mean;
+                              double dn = delta / n;
+                              double dn2 = dn * dn;
+                              double term1 = delta * dn * n1;
+                              _mean += dn;
+                              _m4 += term1 * dn2 * (n*n - 3*n + 3) + 6 * dn2 * _m2 - 4 * dn * _m3;
+                              _m3 += term1 * dn * (n - 2) - 3 * dn * _m2;
+                              _m2 += term1;
                             }
 
+  /// add n entries at once: the moments of each block of entries are
+  /// accumulated in simple (vectorisable) loops about the block's mean
+  /// and then merged into this accumulator
+  inline void add(const double * x, std::size_t n) {
+    const std::size_t block = 1024;
+    for (std::size_t start = 0; start < n; start += block) {
+      std::size_t nb = (n - start < block) ? n - start : block;
+      const double * xb = x + start;
+      double s = 0.0;
+      for (std::size_t i = 0; i < nb; i++) s += xb[i];
+      double mean = s / nb;
+      double d1 = 0.0, d2 = 0.0, d3 = 0.0, d4 = 0.0;
+      for (std::size_t i = 0; i < nb; i++) {
+        double d = xb[i] - mean, dd = d*d;
+        d1 += d; d2 += dd; d3 += dd*d; d4 += dd*dd;
+      }
+      // correct for the rounding error in the mean, c = <x> - mean
+      double c = d1 / nb;
+      AverageAndError other;
+      other._n    = nb;
+      other._mean = mean + c;
+      other._m2   = d2 - nb*c*c;
+      other._m3   = d3 - 3*c*d2 + 2*nb*c*c*c;
+      other._m4   = d4 - 4*c*d3 + 6*c*c*d2 - 3*nb*c*c*c*c;
+      *this += other;
+    }
+  }
+
   /// add vector with entries
-  inline void add(std::vector<double> v)  { 
-      for(unsigned i=0;i<v.size();i++) add(v[i]);
+  inline void add(const std::vector<double> & v)  {
+      if (v.size() > 0) add(&v[0], v.size());
   }
-  
-  /// alternative way to add one or more entries, for consistency with 
+
+  /// alternative way to add one or more entries, for consistency with
   /// SimpleHist, AveragingHist, etc
   inline void add_entry(double x) { add(x); }
-  inline void add_entry(std::vector<double> v) { add(v); }
+  inline void add_entry(const std::vector<double> & v) { add(v); }
 
   /// add one event with a different notation
   inline void operator+= (double x) { add(x); }
 
+  /// merge the entries of another accumulator into this one
+  inline AverageAndError & operator+= (const AverageAndError & other) {
+    if (other._n == 0) return *this;
+    if (_n == 0) {*this = other; return *this;}
+    double na = _n, nb = other._n, n = na + nb;
+    double delta = other._mean - _mean;
+    double delta2 = delta*delta;
+    _m4 += other._m4 + delta2*delta2 * na*nb*(na*na - na*nb + nb*nb)/(n*n*n)
+           + 6*delta2*(na*na*other._m2 + nb*nb*_m2)/(n*n)
+           + 4*delta*(na*other._m3 - nb*_m3)/n;
+    _m3 += other._m3 + delta2*delta * na*nb*(na - nb)/(n*n)
+           + 3*delta*(na*other._m2 - nb*_m2)/n;
+    _m2 += other._m2 + delta2 * na*nb/n;
+    _mean += delta * nb/n;
+    _n += other._n;
+    return *this;
+  }
+
   /// return sum
-  inline double sum() const { return _sum; }
+  inline double sum() const { return _n * _mean; }
 
   /// return sum2, second way for consistency with AveragingHist
-  inline double sum2() const { return _sum2; }
-  inline double sum_of_squares() const { return _sum2; }
+  inline double sum2() const { return _m2 + _n*_mean*_mean; }
+  inline double sum_of_squares() const { return sum2(); }
 
   /// return sum3
-  inline double sum3() const { return _sum3; }
-  
+  inline double sum3() const { return _m3 + 3*_mean*_m2 + _n*_mean*_mean*_mean; }
+
   /// return sum4
-  inline double sum4() const { return _sum4; }
-  
+  inline double sum4() const { double mean2 = _mean*_mean;
+                               return _m4 + 4*_mean*_m3 + 6*mean2*_m2 + _n*mean2*mean2; }
+
   /// return number of events
-  inline int n() const { return _n; }
+  inline int64_t n() const { return _n; }
   /// alternative way to return number of events, for consistency with
   /// SimpleHist, AveragingHist, etc
-  inline int n_entries() const { return n(); }
-  
-  /// allow the user to reset the effective value of n
-  inline void set_n(int n_in) { _n = n_in;}
+  inline int64_t n_entries() const { return n(); }
+
+  /// allow the user to reset the effective value of n (keeping the
+  /// sums of the entries and of their powers unchanged)
+  inline void set_n(int64_t n_in) {
+    double s1 = sum(), s2 = sum2(), s3 = sum3(), s4 = sum4();
+    _n = n_in;
+    if (_n == 0) {_mean = _m2 = _m3 = _m4 = 0.0; return;}
+    _mean = s1/_n;
+    double mean2 = _mean*_mean;
+    _m2 = s2 - _n*mean2;
+    _m3 = s3 - 3*_mean*s2 + 2*_n*mean2*_mean;
+    _m4 = s4 - 4*_mean*s3 + 6*mean2*s2 - 3*_n*mean2*mean2;
+  }
 
   /// calculate and return average
-  inline double average() const { return (_n > 0) ? _sum/_n : 0. ; }
+  inline double average() const { return (_n > 0) ? _mean : 0. ; }
 
   /// calculate and return average of squares, second way for consistency with AveragingHist
-  inline double average2() const { return (_n > 0) ? _sum2/_n : 0. ; }
+  inline double average2() const { return (_n > 0) ? sum2()/_n : 0. ; }
   inline double average_of_squares() const { return average2(); }
 
   /// calculate and return error
-  inline double error() const { return sd()/std::sqrt(_n); }
+  inline double error() const { return sd()/std::sqrt(double(_n)); }
 
   /// return the error on the sum (as opposed to the error on the average)
   inline double error_on_sum() { return error() * n(); }
 
   /// calculate and return the unbiased sample variance
-  inline double variance() const { return (_n > 1) ? std::abs(_sum2 - _sum*_sum/_n)/(_n-1) : 0.; }
+  inline double variance() const { return (_n > 1) ? std::abs(_m2)/(_n-1) : 0.; }
 
   /// calculate and return the standard deviation (i.e. sqrt of the unbiased sample variance)
   inline double sd() const { return (_n > 1) ? std::sqrt(variance()) : 0.; }
@@ -78,20 +148,22 @@ public:
   /// var[S^2] = 1/n ( E[(X-E[X])^4] - (n-3)/(n-1) E[(X-E[X])^2]^2 )
   /// (see also http://www.talkstats.com/showthread.php/12302-Standard-error-of-the-sample-standard-deviation)
   inline double variance_of_variance() const {
-      return  (_n > 1) ? 
-               ( _sum4/_n - 4*_sum3*_sum/pow(_n,2) + ((3-_n)*_sum2*_sum2/pow(_n,2) +
-                 4*(2*_n-3)*_sum2*_sum*_sum/pow(_n,3) + 2*(3-2*_n)*pow(_sum,4)/pow(_n,4) ) / (_n-1) )/_n 
-	      : 0.; 
+      if (_n <= 1) return 0.;
+      double n = _n;
+      double mu2 = _m2/n, mu4 = _m4/n;
+      return (mu4 - (n-3)/(n-1)*mu2*mu2)/n;
   }
-  
+
   /// return error on variance (i.e. the square root of variance_of_variance() )
   inline double error_on_variance() const  { return (_n > 1) ? std::sqrt(variance_of_variance()) : 0.; }
 
   /// return error on standard deviation, given in approximate form as error of sqrt of variance
   inline double error_on_sd() const  { return (_n > 1) ? error_on_variance()/sd()/2. : 0.; }
-  
-double _sum, _sum2, _sum3, _sum4;
-int _n;
+
+private:
+  int64_t _n;
+  /// the mean and the sums of (x - mean)^k for k = 2, 3, 4
+  double _mean, _m2, _m3, _m4;
 
 };
 
@@ -0,0 +1,297 @@
+#ifndef __BOOTSTRAPHIST_HH__
+#define __BOOTSTRAPHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file BootstrapHist.hh
+///
+/// Tools for estimating statistical uncertainties with the bootstrap
+/// (more precisely the "Poisson bootstrap"): in each event, each of R
+/// replicas gets a random weight drawn from a Poisson distribution
+/// with mean 1, and every histogram is filled once with the nominal
+/// weight and once per replica with the replica weights. The spread
+/// of any derived quantity (e.g. a ratio of histograms, or the
+/// position of a peak) across the replicas then gives its statistical
+/// uncertainty, without having to rerun the job.
+///
+/// \code
+///   BootstrapWeights bootstrap(100);                  // R = 100 replicas
+///   BootstrapHist top_candidate_mass(0.0, 300.0, 4.0, bootstrap.nreplicas());
+///   for (...events...) {
+///     bootstrap.set_event(iEvent);
+///     ...
+///     top_candidate_mass.add_entry(top_candidate.m(), bootstrap);
+///   }
+///   // columns: binlo binmid binhi nominal replica-spread
+///   file << top_candidate_mass;
+///   // or look at replica r as a SimpleHist
+///   SimpleHist hr = top_candidate_mass.replica(r);
+/// \endcode
+///
+/// The replica weights come from a counter-based random-number
+/// generator, i.e. they are a fixed function of (seed, event, replica)
+/// with no state carried from one event to the next, so they are
+/// reproducible and can be generated independently in different
+/// threads or jobs. They are stored interleaved with the bins, i.e.
+/// replica r of bin i is at i*R + r, so that filling all replicas is a
+/// single contiguous, vectorisable loop.
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<valarray>
+#include<vector>
+#include<cmath>
+#include<iostream>
+#include<cassert>
+#include<stdint.h>
+
+//----------------------------------------------------------------------
+/// Class that generates the R per-event Poisson(1) replica weights
+class BootstrapWeights {
+public:
+  BootstrapWeights(unsigned int nreplicas, uint64_t seed = 12345)
+    : _weights(nreplicas), _seed(seed) {}
+
+  unsigned int nreplicas() const {return _weights.size();}
+
+  /// generate the weights for the given event number
+  void set_event(uint64_t ievent) {
+    uint64_t key = _mix(_seed ^ _mix(ievent));
+    double * w = &_weights[0];
+    for (unsigned r = 0; r < _weights.size(); r++) {
+      // a uniform random number in [0,1) from the key and the counter
+      double u = (_mix(key + r * golden) >> 11) * (1.0/9007199254740992.0);
+      // and the Poisson(1) variate by (branch-free) inversion of the
+      // cumulative distribution
+      double k = 0;
+      for (unsigned j = 0; j < ncdf; j++) k += (u >= _poisson_cdf()[j]);
+      w[r] = k;
+    }
+  }
+
+  /// the weight for replica r in the current event
+  double operator[](unsigned r) const {return _weights[r];}
+  const double * weights() const {return &_weights[0];}
+
+private:
+  static const uint64_t golden = 0x9E3779B97F4A7C15ULL;
+  static const unsigned ncdf = 10;
+
+  /// the SplitMix64 finaliser
+  static uint64_t _mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  /// the cumulative Poisson(1) probabilities P(k <= j), j = 0..ncdf-1
+  static const double * _poisson_cdf() {
+    static const double cdf[ncdf] = {
+      0.36787944117144233, 0.73575888234288467, 0.91969860292860584,
+      0.98101184312384626, 0.99634015317265637, 0.99940581518241839,
+      0.99991675885071206, 0.99998975080332569, 0.99999887479740239,
+      0.99999988857452202};
+    return cdf;
+  }
+
+  std::vector<double> _weights;
+  uint64_t _seed;
+};
+
+
+//----------------------------------------------------------------------
+/// Histogram filled with a nominal (unit) weight and with R bootstrap
+/// replica weights
+class BootstrapHist {
+public:
+  BootstrapHist() {};
+
+  BootstrapHist(double minv, double maxv, double bin_size, unsigned int nreplicas) {
+    declare(minv, maxv, bin_size, nreplicas);
+  }
+
+  BootstrapHist(double minv, double maxv, int n, unsigned int nreplicas) {
+    declare(minv, maxv, n, nreplicas);
+  }
+
+  BootstrapHist(double minv, double maxv, unsigned int n, unsigned int nreplicas) {
+    declare(minv, maxv, n, nreplicas);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, double bin_size, unsigned int nreplicas) {
+    declare(minv, maxv, unsigned(0.5+(maxv-minv)/bin_size), nreplicas);
+  }
+
+  void declare(double minv, double maxv, int n, unsigned int nreplicas) {
+    declare(minv, maxv, unsigned(n), nreplicas);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, unsigned int n, unsigned int nreplicas) {
+    _minv = minv; _maxv = maxv; _dv = (maxv-minv)/n; _inv_dv = 1.0/_dv;
+    _n = n; _nrep = nreplicas;
+    _nominal.resize(n+1);
+    _replicas.resize((n+1)*nreplicas);
+    _replica_weight_v.resize(nreplicas);
+    _replica_weight_vsq.resize(nreplicas);
+    reset();
+  }
+
+  /// reset the contents of the histogram to zero
+  void reset() {
+    _nominal = 0.0;
+    _replicas = 0.0;
+    _weight_v = 0.0;
+    _weight_vsq = 0.0;
+    _replica_weight_v = 0.0;
+    _replica_weight_vsq = 0.0;
+    _n_entries = 0.0;
+  }
+
+  double min() const {return _minv;};
+  double max() const {return _maxv;};
+  unsigned int size() const {return _n;}
+  unsigned int outflow_size() const {return _n+1;}
+  unsigned int nreplicas() const {return _nrep;}
+
+  double binlo (int i) const {return i*_dv + _minv;};
+  double binhi (int i) const {return (i+1)*_dv + _minv;};
+  double binmid(int i) const {return (i+0.5)*_dv + _minv;};
+  double binsize()     const {return _dv;};
+
+  unsigned int bin(double v) const {
+    if (v >= _minv && v < _maxv) {
+      unsigned i = unsigned((v-_minv)*_inv_dv);
+      if (i < _n) return i;
+    }
+    return _n;
+  }
+
+  /// add an entry with the current event's replica weights (times
+  /// an overall weight)
+  void add_entry(double v, const BootstrapWeights & bootstrap, double weight = 1.0) {
+    assert(bootstrap.nreplicas() == _nrep);
+    unsigned i = bin(v);
+    double wv = weight * v, wvsq = wv * v;
+    _nominal[i] += weight;
+    _weight_v   += wv;
+    _weight_vsq += wvsq;
+    _n_entries  += 1.0;
+    double * dest = &_replicas[i*_nrep];
+    double * rv   = &_replica_weight_v[0];
+    double * rvsq = &_replica_weight_vsq[0];
+    const double * w = bootstrap.weights();
+    for (unsigned r = 0; r < _nrep; r++) {
+      dest[r] += weight * w[r];
+      rv[r]   += wv * w[r];
+      rvsq[r] += wvsq * w[r];
+    }
+  }
+
+  /// the number of entries (the same for the nominal histogram and
+  /// all replicas)
+  double n_entries() const {return _n_entries;}
+
+  /// the nominal content of bin i
+  double operator[](unsigned i) const {return _nominal[i];}
+  /// the content of bin i in replica r
+  double operator()(unsigned i, unsigned r) const {return _replicas[i*_nrep + r];}
+
+  /// the standard deviation across replicas of the content of bin i
+  double spread(unsigned i) const {
+    if (_nrep < 2) return 0.0;
+    double sum = 0, sum2 = 0;
+    const double * rep = &_replicas[i*_nrep];
+    for (unsigned r = 0; r < _nrep; r++) {sum += rep[r]; sum2 += rep[r]*rep[r];}
+    return std::sqrt(std::abs(sum2 - sum*sum/_nrep)/(_nrep-1));
+  }
+
+  /// the nominal histogram, as a SimpleHist (including its moments
+  /// and number of entries)
+  SimpleHist nominal() const {
+    SimpleHist result(_minv, _maxv, _n);
+    double total_weight = 0.0;
+    for (unsigned i = 0; i <= _n; i++) {
+      result.set(i, _nominal[i]);
+      total_weight += _nominal[i];
+    }
+    result.set_moments(_weight_v, _weight_vsq, total_weight, _n_entries);
+    return result;
+  }
+
+  /// replica r, as a SimpleHist (including its moments and number of
+  /// entries)
+  SimpleHist replica(unsigned r) const {
+    assert(r < _nrep);
+    SimpleHist result(_minv, _maxv, _n);
+    double total_weight = 0.0;
+    for (unsigned i = 0; i <= _n; i++) {
+      result.set(i, (*this)(i,r));
+      total_weight += (*this)(i,r);
+    }
+    result.set_moments(_replica_weight_v[r], _replica_weight_vsq[r], total_weight, _n_entries);
+    return result;
+  }
+
+  // Operations with constants ---------------------------------------
+  BootstrapHist & operator*=(double fact) {
+    _nominal *= fact;
+    _replicas *= fact;
+    _weight_v *= fact;
+    _weight_vsq *= fact;
+    _replica_weight_v *= fact;
+    _replica_weight_vsq *= fact;
+    return *this;
+  };
+  BootstrapHist & operator/=(double fact) {
+    *this *= 1.0/fact;
+    return *this;
+  };
+
+  /// merge another histogram (e.g. from another thread or job, with
+  /// the same binning and number of replicas) into this one
+  BootstrapHist & operator+=(const BootstrapHist & other) {
+    assert(other._n == _n && other._nrep == _nrep);
+    _nominal += other._nominal;
+    _replicas += other._replicas;
+    _weight_v += other._weight_v;
+    _weight_vsq += other._weight_vsq;
+    _replica_weight_v += other._replica_weight_v;
+    _replica_weight_vsq += other._replica_weight_vsq;
+    _n_entries += other._n_entries;
+    return *this;
+  };
+
+private:
+  double _minv, _maxv, _dv, _inv_dv;
+  unsigned int _n, _nrep;
+  std::valarray<double> _nominal;
+  std::valarray<double> _replicas;
+  /// sums of weight*v and weight*v*v for the nominal histogram and
+  /// for each replica
+  double _weight_v, _weight_vsq;
+  std::valarray<double> _replica_weight_v, _replica_weight_vsq;
+  double _n_entries;
+};
+
+
+/// output the histogram, with columns binlo, binmid, binhi, nominal
+/// value and spread across replicas; multiplied by the factor norm
+inline void output(const BootstrapHist & hist,
+                   std::ostream * ostr = (&std::cout),
+                   double norm = 1.0) {
+  for (unsigned i = 0; i < hist.size(); i++) {
+    *ostr << hist.binlo(i)  << " "
+          << hist.binmid(i) << " "
+          << hist.binhi(i)  << " "
+          << hist[i]*norm   << " "
+          << hist.spread(i)*norm << std::endl;
+  }
+}
+
+inline std::ostream & operator<<(std::ostream & ostr, const BootstrapHist & hist) {
+  output(hist, &ostr);
+  return ostr;
+}
+
+#endif // __BOOTSTRAPHIST_HH__
@@ -0,0 +1,177 @@
+#ifndef __COVARIANCEACCUMULATOR_HH__
+#define __COVARIANCEACCUMULATOR_HH__
+
+#include<cmath>
+#include<vector>
+#include<string>
+#include<iostream>
+#include<iomanip>
+#include<algorithm>
+#include<cassert>
+#include<stdint.h>
+
+/// micro class to calculate the means and covariances of a set of
+/// observables that are measured together (once per event), e.g.
+///
+/// \code
+///   vector<string> names;
+///   names.push_back("njets"); names.push_back("mW"); ...
+///   CovarianceAccumulator event_obs(names);
+///   ...
+///   double obs[] = {double(jets.size()), W_candidate.m(), ...};
+///   event_obs.add(obs);
+///   ...
+///   event_obs.output_correlations(&file, "# ");
+/// \endcode
+///
+/// The covariances are accumulated in one pass with the Welford
+/// update, as sums of products of deviations from the running means,
+/// and only the upper triangle (including the diagonal) of the
+/// symmetric matrix is stored, packed row by row. Two accumulators
+/// (e.g. from different threads or jobs) can be merged exactly with
+/// +=.
+class CovarianceAccumulator {
+public:
+
+  /// constructor for nvar observables (named "0", "1", ...)
+  CovarianceAccumulator(unsigned nvar = 0) {
+    std::vector<std::string> names;
+    for (unsigned i = 0; i < nvar; i++) names.push_back(_to_string(i));
+    _init(names);
+  }
+
+  /// constructor for observables with the given names
+  CovarianceAccumulator(const std::vector<std::string> & names) { _init(names); }
+
+  /// add one entry, i.e. the values x[0..nvar-1] of all observables
+  inline void add(const double * x) {
+    unsigned nv = nvar();
+    _n += 1;
+    double n = _n;
+    for (unsigned i = 0; i < nv; i++) {
+      _delta[i] = x[i] - _mean[i];
+      _mean[i] += _delta[i] / n;
+    }
+    // C_ij += (x_i - old mean_i) (x_j - new mean_j)
+    double * c = &_cov[0];
+    for (unsigned i = 0; i < nv; i++) {
+      double di = _delta[i];
+      for (unsigned j = i; j < nv; j++) *(c++) += di * (x[j] - _mean[j]);
+    }
+  }
+
+  /// add one entry, given as a vector
+  inline void add(const std::vector<double> & x) {
+    assert(x.size() == nvar());
+    add(&x[0]);
+  }
+
+  /// alternative way to add an entry, for consistency with
+  /// AverageAndError, SimpleHist, etc
+  inline void add_entry(const std::vector<double> & x) { add(x); }
+
+  /// merge the entries of another accumulator (with the same
+  /// observables) into this one
+  inline CovarianceAccumulator & operator+= (const CovarianceAccumulator & other) {
+    assert(other.nvar() == nvar());
+    if (other._n == 0) return *this;
+    if (_n == 0) {*this = other; return *this;}
+    unsigned nv = nvar();
+    double na = _n, nb = other._n, n = na + nb;
+    for (unsigned i = 0; i < nv; i++) _delta[i] = other._mean[i] - _mean[i];
+    unsigned k = 0;
+    for (unsigned i = 0; i < nv; i++) {
+      for (unsigned j = i; j < nv; j++, k++) {
+        _cov[k] += other._cov[k] + _delta[i] * _delta[j] * na * nb / n;
+      }
+    }
+    for (unsigned i = 0; i < nv; i++) _mean[i] += _delta[i] * nb / n;
+    _n += other._n;
+    return *this;
+  }
+
+  /// return the number of observables
+  inline unsigned nvar() const { return _names.size(); }
+  /// return the name of observable i
+  inline const std::string & name(unsigned i) const { return _names[i]; }
+
+  /// return number of entries
+  inline int64_t n() const { return _n; }
+  inline int64_t n_entries() const { return n(); }
+
+  /// return the average of observable i
+  inline double average(unsigned i) const { return _mean[i]; }
+
+  /// return the unbiased sample covariance of observables i and j
+  inline double covariance(unsigned i, unsigned j) const {
+    return (_n > 1) ? _cov[_index(i,j)]/(_n-1) : 0.;
+  }
+
+  /// return the unbiased sample variance of observable i
+  inline double variance(unsigned i) const { return covariance(i,i); }
+
+  /// return the standard deviation of observable i
+  inline double sd(unsigned i) const { return std::sqrt(variance(i)); }
+
+  /// return the error on the average of observable i
+  inline double error(unsigned i) const { return (_n > 0) ? sd(i)/std::sqrt(double(_n)) : 0.; }
+
+  /// return the correlation coefficient of observables i and j (zero
+  /// if either has no spread)
+  inline double correlation(unsigned i, unsigned j) const {
+    double norm = std::sqrt(_cov[_index(i,i)] * _cov[_index(j,j)]);
+    return (norm > 0) ? _cov[_index(i,j)]/norm : 0.;
+  }
+
+  /// write the averages and the correlation matrix, with each line
+  /// starting with prefix (e.g. "# " to make them comments)
+  void output_correlations(std::ostream * ostr = (&std::cout),
+                           const std::string & prefix = "") const {
+    unsigned nv = nvar();
+    for (unsigned i = 0; i < nv; i++) {
+      *ostr << prefix << "<" << _names[i] << "> = " << average(i) << " +- " << error(i)
+            << ", sd = " << sd(i) << std::endl;
+    }
+    *ostr << prefix << "correlation matrix (" << n() << " entries)" << std::endl;
+    *ostr << prefix << std::setw(12) << "";
+    for (unsigned j = 0; j < nv; j++) *ostr << " " << std::setw(12) << _names[j];
+    *ostr << std::endl;
+    for (unsigned i = 0; i < nv; i++) {
+      *ostr << prefix << std::setw(12) << _names[i];
+      for (unsigned j = 0; j < nv; j++) *ostr << " " << std::setw(12) << correlation(i,j);
+      *ostr << std::endl;
+    }
+  }
+
+private:
+  void _init(const std::vector<std::string> & names) {
+    _names = names;
+    unsigned nv = nvar();
+    _mean.assign(nv, 0.0);
+    _delta.assign(nv, 0.0);
+    _cov.assign(nv*(nv+1)/2, 0.0);
+    _n = 0;
+  }
+
+  /// the position of (i,j) in the packed upper triangle
+  inline unsigned _index(unsigned i, unsigned j) const {
+    if (i > j) std::swap(i,j);
+    return i*nvar() - i*(i-1)/2 + (j-i);
+  }
+
+  static std::string _to_string(unsigned i) {
+    std::string result;
+    do {result.insert(result.begin(), char('0' + i%10)); i /= 10;} while (i > 0);
+    return result;
+  }
+
+  std::vector<std::string> _names;
+  int64_t _n;
+  std::vector<double> _mean;
+  /// scratch space for the deviations from the mean
+  std::vector<double> _delta;
+  /// the packed upper triangle of sum (x_i - mean_i)(x_j - mean_j)
+  std::vector<double> _cov;
+};
+
+#endif // __COVARIANCEACCUMULATOR_HH__
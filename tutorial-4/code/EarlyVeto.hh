@@ -0,0 +1,122 @@
+#ifndef __EARLYVETO_HH__
+#define __EARLYVETO_HH__
+
+//----------------------------------------------------------------------
+/// \file EarlyVeto.hh
+///
+/// EarlyVeto is a Pythia UserHooks that applies cheap cuts supplied
+/// by the analysis at the process level (after the hard process and
+/// resonance decays) and/or at the parton level (after the showers
+/// and MPI, before hadronisation), so that events that the analysis
+/// would reject anyway never reach hadronisation, conversion to
+/// PseudoJets or clustering:
+///
+/// \code
+///   class MuonCut : public EarlyVetoCut {
+///   public:
+///     // true if the event may pass the analysis cuts
+///     bool pass(const Pythia8::Event & event) const {...}
+///     std::string description() const {return "muon in acceptance";}
+///   };
+///   ...
+///   MuonCut muon_cut;
+///   EarlyVeto early_veto;
+///   early_veto.set_parton_cut(&muon_cut);
+///   pythia.setUserHooksPointer(&early_veto);
+///   ...
+///   early_veto.report(cout);
+/// \endcode
+///
+/// Pythia replaces a vetoed event with a new one within the same call
+/// to pythia.next(), so the event loop only sees events that passed
+/// the cuts. The cuts must be looser than (or equivalent to) the
+/// analysis cuts, otherwise the results are biased; report() gives
+/// the number of events tried and vetoed at each stage, so that
+/// the rates (and the results) can be checked against a run without
+/// the veto.
+//----------------------------------------------------------------------
+
+#include "Pythia8/Pythia.h"
+#include <string>
+#include <iostream>
+#include <stdint.h>
+
+//----------------------------------------------------------------------
+/// Base class for the cuts used by EarlyVeto
+class EarlyVetoCut {
+public:
+  virtual ~EarlyVetoCut() {}
+  /// returns true if the event should be kept
+  virtual bool pass(const Pythia8::Event & event) const = 0;
+  /// a description of the cut, for the report
+  virtual std::string description() const {return "";}
+};
+
+//----------------------------------------------------------------------
+/// The UserHooks that applies the cuts (which are not owned by it, and
+/// must remain in existence for as long as it is used)
+class EarlyVeto : public Pythia8::UserHooks {
+public:
+  EarlyVeto() : _process_cut(0), _parton_cut(0) {reset_counters();}
+
+  /// set the cut applied to the process record
+  void set_process_cut(const EarlyVetoCut * cut) {_process_cut = cut;}
+
+  /// set the cut applied to the event record at the end of the
+  /// parton level (before hadronisation)
+  void set_parton_cut(const EarlyVetoCut * cut) {_parton_cut = cut;}
+
+  // the UserHooks interface
+  virtual bool canVetoProcessLevel() {return _process_cut != 0;}
+  virtual bool doVetoProcessLevel(Pythia8::Event & process) {
+    _n_process_tried++;
+    if (_process_cut->pass(process)) return false;
+    _n_process_vetoed++;
+    return true;
+  }
+
+  virtual bool canVetoPartonLevel() {return _parton_cut != 0;}
+  virtual bool doVetoPartonLevel(const Pythia8::Event & event) {
+    _n_parton_tried++;
+    if (_parton_cut->pass(event)) return false;
+    _n_parton_vetoed++;
+    return true;
+  }
+
+  /// the number of events tried and vetoed at each stage
+  uint64_t n_process_tried () const {return _n_process_tried;}
+  uint64_t n_process_vetoed() const {return _n_process_vetoed;}
+  uint64_t n_parton_tried  () const {return _n_parton_tried;}
+  uint64_t n_parton_vetoed () const {return _n_parton_vetoed;}
+
+  void reset_counters() {
+    _n_process_tried = _n_process_vetoed = 0;
+    _n_parton_tried  = _n_parton_vetoed  = 0;
+  }
+
+  /// write the number of events tried and vetoed at each stage, with
+  /// each line starting with prefix (e.g. "# " to make them comments)
+  void report(std::ostream & ostr, const std::string & prefix = "") const {
+    if (_process_cut) _report(ostr, prefix, "process", _process_cut->description(),
+                              _n_process_tried, _n_process_vetoed);
+    if (_parton_cut)  _report(ostr, prefix, "parton" , _parton_cut->description(),
+                              _n_parton_tried, _n_parton_vetoed);
+  }
+
+private:
+  static void _report(std::ostream & ostr, const std::string & prefix,
+                      const std::string & level, const std::string & description,
+                      uint64_t n_tried, uint64_t n_vetoed) {
+    ostr << prefix << "early veto at " << level << " level";
+    if (description != "") ostr << " (" << description << ")";
+    ostr << ": " << n_vetoed << " of " << n_tried << " events vetoed";
+    if (n_tried > 0) ostr << " (" << 100.0*n_vetoed/n_tried << "%)";
+    ostr << std::endl;
+  }
+
+  const EarlyVetoCut * _process_cut, * _parton_cut;
+  uint64_t _n_process_tried, _n_process_vetoed;
+  uint64_t _n_parton_tried, _n_parton_vetoed;
+};
+
+#endif // __EARLYVETO_HH__
@@ -0,0 +1,114 @@
+#ifndef __EVENTVIEW_HH__
+#define __EVENTVIEW_HH__
+
+//----------------------------------------------------------------------
+/// \file EventView.hh
+///
+/// EventView is a light view of the final-state particles of a
+/// Pythia8::Event (it holds just their indices in the event), which
+/// answers event-level questions directly from the event record,
+/// e.g.
+///
+/// \code
+///   EventView view(pythia.event);
+///   int imuon = view.hardest(13, ptmin, ymax);  // -1 if none
+///   if (imuon < 0) continue;
+///   vector<PseudoJet> particles = view.pseudojets(pred);
+/// \endcode
+///
+/// so that PseudoJets, with their copy of the Pythia8 particle as
+/// user info, are only made for the events that pass such cuts, and
+/// only for the particles that are actually needed (e.g. those that
+/// go into the clustering).
+//----------------------------------------------------------------------
+
+#include "Pythia8/Event.h"
+#include "Pythia8/FJcore.h"
+#include "FJCorePythia.hh"
+#include <cmath>
+#include <vector>
+
+class EventView {
+public:
+  EventView(const Pythia8::Event & event) : _event(event) {
+    for (int i = 0; i < event.size(); ++i) {
+      if (event[i].isFinal()) _final.push_back(i);
+    }
+  }
+
+  /// the underlying event
+  const Pythia8::Event & event() const {return _event;}
+
+  /// the indices in the event of the final-state particles
+  const std::vector<int> & final_indices() const {return _final;}
+
+  /// the number of final-state particles
+  unsigned n_final() const {return _final.size();}
+
+  /// the number of visible final-state particles (i.e. excluding
+  /// neutrinos and other invisible particles)
+  unsigned n_visible() const {
+    unsigned n = 0;
+    for (unsigned i = 0; i < _final.size(); i++) {
+      if (_event[_final[i]].isVisible()) n++;
+    }
+    return n;
+  }
+
+  /// returns true if there is a final-state particle with the given
+  /// id, pt >= ptmin and |y| <= ymax (stopping at the first one found)
+  bool has(int id, double ptmin, double ymax) const {
+    for (unsigned i = 0; i < _final.size(); i++) {
+      if (_in_acceptance(_event[_final[i]], id, ptmin, ymax)) return true;
+    }
+    return false;
+  }
+
+  /// returns the index in the event of the hardest final-state
+  /// particle with the given id, pt >= ptmin and |y| <= ymax, or -1
+  /// if there is none
+  int hardest(int id, double ptmin, double ymax) const {
+    int result = -1;
+    double result_pt = 0.0;
+    for (unsigned i = 0; i < _final.size(); i++) {
+      const Pythia8::Particle & p = _event[_final[i]];
+      if (!_in_acceptance(p, id, ptmin, ymax)) continue;
+      if (result < 0 || p.pT() > result_pt) {result = _final[i]; result_pt = p.pT();}
+    }
+    return result;
+  }
+
+  /// returns PseudoJets (with Py8Particle user info) for the
+  /// final-state particles for which pred(i, event[i]) is true, where
+  /// i is the particle's index in the event
+  template<class Pred>
+  std::vector<Pythia8::fjcore::PseudoJet> pseudojets(Pred pred) const {
+    std::vector<Pythia8::fjcore::PseudoJet> result;
+    result.reserve(_final.size());
+    for (unsigned i = 0; i < _final.size(); i++) {
+      const Pythia8::Particle & p = _event[_final[i]];
+      if (pred(_final[i], p)) result.push_back(Pythia8::fjcore::PseudoJet(p));
+    }
+    return result;
+  }
+
+  /// returns PseudoJets for all the final-state particles
+  std::vector<Pythia8::fjcore::PseudoJet> pseudojets() const {
+    std::vector<Pythia8::fjcore::PseudoJet> result;
+    result.reserve(_final.size());
+    for (unsigned i = 0; i < _final.size(); i++) {
+      result.push_back(Pythia8::fjcore::PseudoJet(_event[_final[i]]));
+    }
+    return result;
+  }
+
+private:
+  static bool _in_acceptance(const Pythia8::Particle & p, int id, double ptmin, double ymax) {
+    return p.id() == id && p.pT() >= ptmin && std::abs(p.y()) <= ymax;
+  }
+
+  const Pythia8::Event & _event;
+  std::vector<int> _final;
+};
+
+#endif // __EVENTVIEW_HH__
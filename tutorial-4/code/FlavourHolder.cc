@@ -27,6 +27,9 @@
 
 #include<valarray>
 #include<iostream>
+#include<iomanip>
+#include<cstdlib>
+#include<mutex>
 #include "FlavourHolder.hh"
 
 using namespace std;
@@ -43,15 +46,33 @@ using namespace std;
 /// written for the jet-flavour work with Andrea Banfi and Giulia
 /// Zanderighi.
 ///
-FlavourHolder::FlavourHolder(int idhep): _flav_content(7,0), _idhep(idhep) {
+/// If idhep is not understood, the flavour content is left at zero,
+/// is_known() returns false and the idhep is recorded (see
+/// record_unknown()).
+///
+FlavourHolder::FlavourHolder(int idhep): _flav_content(7,0), _idhep(idhep), _known(true) {
 
   // [NB: the following are now done in the member initialiser list]
   // make _flav_content of size 7 to allow easy access to entries 1..6 
   //_flav_content.resize(7);
   //_idhep = idhep;
 
+  if (!decode(idhep, &_flav_content[0])) {
+    // decode may have partially filled the content before failing
+    _flav_content.assign(7,0);
+    _known = false;
+    record_unknown(_idhep);
+  }
+}
+
+//----------------------------------------------------------------------
+/// set flav_content[iflv] (iflv = 1..6, with flav_content already
+/// zeroed) to the net number of quarks of flavour iflv in the particle
+/// labelled by idhep; returns false if idhep is not understood.
+bool FlavourHolder::decode(int idhep, int * flav_content) {
+
   // for particles with illicit (zero) idhep, no work to be done
-  if (_idhep == 0) return;
+  if (idhep == 0) return true;
 
   int netsign = (idhep >= 0 ? +1 : -1);
   idhep = abs(idhep);
@@ -72,12 +93,11 @@ FlavourHolder::FlavourHolder(int idhep): _flav_content(7,0), _idhep(idhep) {
   //        <<") contained more digits than are understood."<<endl;
   //   exit(-1);}
   
-  // start this part with _flav_content already initialised to zero
-  // in constructor
+  // start this part with flav_content already initialised to zero
+  // by the caller
   if (ndigits == 1) { // a lone quark
-    if (digit[0] > 6 || digit[0] == 0) {
-      cerr << "FlavourHolder failed to understand idhep = "<<_idhep<<endl; exit(-1);}
-    _flav_content[digit[0]] = netsign;
+    if (digit[0] > 6 || digit[0] == 0) return false;
+    flav_content[digit[0]] = netsign;
 
   } else if (ndigits == 2) { // a lepton, photon or cluster [flav lost...]
     // do nothing...
@@ -85,25 +105,66 @@ FlavourHolder::FlavourHolder(int idhep): _flav_content(7,0), _idhep(idhep) {
   } else { // must be a meson, cluster or baryon
     // check sanity of codes
     for (int i=1; i < ndigits; i++) {
-      if (digit[i] > 6) {cerr << "FlavourHolder failed to understand idhep = "
-			       <<_idhep<<endl; exit(-1);}}
+      if (digit[i] > 6) return false;}
     
     // now deal with different cases
     if (ndigits == 4) { // diquark [nm0x] or baryon [nmpx]
       for (int i=1; i < ndigits; i++) {
-	if (digit[i] > 0) _flav_content[digit[i]] += netsign;}
+	if (digit[i] > 0) flav_content[digit[i]] += netsign;}
     } else if (ndigits == 3) { // meson [nmx]
       // Beware of PDG convention that says that a K+ or B+ are a
       // particle and so have positive idhep (i.e. flavcodes > 1). So
       if (digit[2] == 3 || digit[2] == 5) netsign = -netsign;
-      _flav_content[digit[2]] += netsign;
-      _flav_content[digit[1]] -= netsign;
+      flav_content[digit[2]] += netsign;
+      flav_content[digit[1]] -= netsign;
     } else {
-      cerr << "FlavourHolder failed to understand idhep = " <<_idhep<<endl; exit(-1);}
+      return false;}
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------
+namespace {
+  // the record of idheps that were not understood, and a mutex so
+  // that it can be updated from several threads
+  std::map<int,uint64_t> & unknown_id_counts() {
+    static std::map<int,uint64_t> counts;
+    return counts;
+  }
+  std::mutex & unknown_id_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+}
+
+void FlavourHolder::record_unknown(int idhep) {
+  std::lock_guard<std::mutex> lock(unknown_id_mutex());
+  uint64_t & count = unknown_id_counts()[idhep];
+  if (count == 0) {
+    cerr << "FlavourHolder failed to understand idhep = " << idhep
+         << "; treating it as flavourless (further occurrences will be "
+         << "counted and reported by FlavourHolder::print_unknown_summary())" << endl;
   }
+  count++;
+}
 
+std::map<int,uint64_t> FlavourHolder::unknown_counts() {
+  std::lock_guard<std::mutex> lock(unknown_id_mutex());
+  return unknown_id_counts();
 }
 
+void FlavourHolder::print_unknown_summary(std::ostream & ostr) {
+  std::map<int,uint64_t> counts = unknown_counts();
+  if (counts.size() == 0) return;
+  ostr << "# FlavourHolder: idhep values that were not understood (treated as flavourless)" << endl;
+  ostr << "#      idhep   occurrences" << endl;
+  for (std::map<int,uint64_t>::const_iterator it = counts.begin(); it != counts.end(); it++) {
+    ostr << "# " << setw(10) << it->first << "   " << it->second << endl;
+  }
+}
+
+void FlavourHolder::print_unknown_summary() {print_unknown_summary(cerr);}
+
 // return the particle chage
 double FlavourHolder::charge() const {
   // with leptons it's easy
@@ -119,3 +180,71 @@ double FlavourHolder::charge() const {
   }
   return chg/3.0;
 }
+
+
+//----------------------------------------------------------------------
+namespace {
+  /// the number of entries in the table of precomputed PDG ids; the
+  /// decoding only uses the lowest four digits of the id, so this
+  /// covers all cases
+  const int pdg_table_size = 10000;
+
+  /// the precomputed information for one (positive) PDG id
+  struct PDGTableEntry {
+    uint64_t packed;       ///< the PackedFlavour word
+    int8_t   charge3;      ///< 3 x the charge
+    int8_t   hadron_charge3; ///< 3 x the charge from the quark content
+    bool     known;        ///< false if the id is not understood
+  };
+
+  /// the table, filled on first use
+  class PDGTable {
+  public:
+    PDGTable() : entries(pdg_table_size) {
+      for (int id = 0; id < pdg_table_size; id++) {
+        PDGTableEntry & entry = entries[id];
+        int content[7] = {0,0,0,0,0,0,0};
+        entry.known = FlavourHolder::decode(id, content);
+        // unknown ids are treated as flavourless
+        if (!entry.known) for (int iflv = 1; iflv <= 6; iflv++) content[iflv] = 0;
+        uint64_t packed = 0;
+        int hadron_charge3 = 0;
+        for (int iflv = 6; iflv >= 1; iflv--) {
+          packed = (packed << 10) + uint64_t(int64_t(content[iflv]));
+          hadron_charge3 += content[iflv] * (iflv%2==0 ? 2 : -1);
+        }
+        entry.packed = packed;
+        entry.hadron_charge3 = hadron_charge3;
+        entry.charge3 = (id >= 11 && id <= 16 && id%2 != 0) ? -3 : hadron_charge3;
+      }
+    }
+    std::vector<PDGTableEntry> entries;
+  };
+
+  const PDGTable & pdg_table() {
+    static const PDGTable table;
+    return table;
+  }
+}
+
+//----------------------------------------------------------------------
+/// decode the n PDG ids in ids[], setting flavours[i] to the net flavour
+/// content of particle i and (if charges is non-null) charges[i] to its
+/// charge, with the same conventions as FlavourHolder and
+/// FlavourHolder::charge().
+void decode_pdg_ids(const int * ids, std::size_t n,
+                    PackedFlavour * flavours, double * charges) {
+  const PDGTableEntry * table = &pdg_table().entries[0];
+  for (std::size_t i = 0; i < n; i++) {
+    int id = ids[i];
+    int abs_id = abs(id);
+    // ids beyond the table (excited states, etc.) are decoded from
+    // their lowest four digits, with the charge from the quark content
+    bool in_table = (abs_id < pdg_table_size);
+    const PDGTableEntry & entry = table[in_table ? abs_id : abs_id % pdg_table_size];
+    if (!entry.known) FlavourHolder::record_unknown(id);
+    int64_t sign = (id >= 0) ? 1 : -1;
+    flavours[i] = PackedFlavour::from_packed(entry.packed * uint64_t(sign));
+    if (charges) charges[i] = sign * (in_table ? entry.charge3 : entry.hadron_charge3) / 3.0;
+  }
+}
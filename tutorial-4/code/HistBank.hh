@@ -0,0 +1,260 @@
+#ifndef __HISTBANK_HH__
+#define __HISTBANK_HH__
+
+//----------------------------------------------------------------------
+/// \file HistBank.hh
+///
+/// A HistBank holds many uniformly-binned histograms in a single
+/// contiguous, cache-line aligned block of memory. Histograms are
+/// declared by name at the start of the run, which returns an integer
+/// handle that is then used in the event loop:
+///
+/// \code
+///   HistBank hists;
+///   HistBank::Handle jet_mass = hists.declare("jet mass", 0.0, 150.0, 2.0);
+///   ...
+///   hists.add_entry(jet_mass, jets[i].m());
+///   ...
+///   file << hists;   // writes "# jet mass", the histogram, etc.
+/// \endcode
+///
+/// Since all bins (and moments) live in one block, merging banks
+/// (e.g. from different threads), rescaling them and reading or
+/// writing them in binary form are each a single loop over (or copy
+/// of) that block. Individual histograms can be extracted as
+/// SimpleHists with hist(handle) or hist(name).
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<string>
+#include<vector>
+#include<map>
+#include<iostream>
+#include<cassert>
+#include<cstdlib>
+#include<cstring>
+
+class HistBank {
+public:
+  typedef unsigned int Handle;
+
+  HistBank() : _arena(0), _arena_size(0) {}
+  HistBank(const HistBank & other) : _arena(0), _arena_size(0) {*this = other;}
+  ~HistBank() {std::free(_arena);}
+
+  HistBank & operator=(const HistBank & other) {
+    if (&other == this) return *this;
+    _entries = other._entries;
+    _handles = other._handles;
+    _allocate(other._arena_size);
+    if (_arena_size > 0) std::memcpy(_arena, other._arena, _arena_size*sizeof(double));
+    return *this;
+  }
+
+  /// declare a histogram with the given name and binning, and return
+  /// the handle to be used to fill it. All declarations should be
+  /// made before filling starts, since each one reallocates the bank.
+  Handle declare(const std::string & name, double minv, double maxv, double bin_size) {
+    return declare(name, minv, maxv, unsigned(0.5+(maxv-minv)/bin_size));
+  }
+
+  Handle declare(const std::string & name, double minv, double maxv, int n) {
+    return declare(name, minv, maxv, unsigned(n));
+  }
+
+  Handle declare(const std::string & name, double minv, double maxv, unsigned int n) {
+    if (_handles.count(name)) {
+      std::cerr << "HistBank: histogram \"" << name << "\" declared twice" << std::endl;
+      exit(-1);
+    }
+    Entry entry;
+    entry.name = name;
+    entry.minv = minv; entry.maxv = maxv; entry.n = n;
+    entry.dv = (maxv-minv)/n; entry.inv_dv = 1.0/entry.dv;
+    entry.offset = _arena_size;
+    Handle handle = _entries.size();
+    _entries.push_back(entry);
+    _handles[name] = handle;
+
+    // bins, outflow, and the three moments, padded to a cache line
+    std::size_t new_size = _arena_size + _padded(n + 1 + nmoments);
+    double * old_arena = _arena;
+    std::size_t old_size = _arena_size;
+    _arena = 0;
+    _allocate(new_size);
+    if (old_size > 0) std::memcpy(_arena, old_arena, old_size*sizeof(double));
+    std::free(old_arena);
+    return handle;
+  }
+
+  /// return the handle for the named histogram
+  Handle handle(const std::string & name) const {
+    std::map<std::string,Handle>::const_iterator it = _handles.find(name);
+    if (it == _handles.end()) {
+      std::cerr << "HistBank: no histogram called \"" << name << "\"" << std::endl;
+      exit(-1);
+    }
+    return it->second;
+  }
+
+  /// number of histograms in the bank
+  unsigned int nhist() const {return _entries.size();}
+  const std::string & name(Handle h) const {return _entries[h].name;}
+
+  /// the bin for value v in histogram h (size of h if outside the range)
+  unsigned int bin(Handle h, double v) const {
+    const Entry & entry = _entries[h];
+    if (v >= entry.minv && v < entry.maxv) {
+      unsigned i = unsigned((v-entry.minv)*entry.inv_dv);
+      if (i < entry.n) return i;
+    }
+    return entry.n;
+  }
+
+  void add_entry(Handle h, double v, double weight = 1.0) {
+    const Entry & entry = _entries[h];
+    double * data = _arena + entry.offset;
+    data[bin(h,v)] += weight;
+    double * moments = data + entry.n + 1;
+    moments[0] += weight * v;
+    moments[1] += weight * v * v;
+    moments[2] += 1.0;
+  }
+
+  /// access bin i of histogram h (i = size is the outflow bin)
+  double & operator()(Handle h, unsigned i) {return _arena[_entries[h].offset + i];}
+  const double & operator()(Handle h, unsigned i) const {return _arena[_entries[h].offset + i];}
+
+  /// return a copy of histogram h as a SimpleHist (including its
+  /// moments and number of entries)
+  SimpleHist hist(Handle h) const {
+    const Entry & entry = _entries[h];
+    const double * data = _arena + entry.offset;
+    SimpleHist result(entry.minv, entry.maxv, entry.n);
+    double total_weight = 0.0;
+    for (unsigned i = 0; i <= entry.n; i++) {
+      result.set(i, data[i]);
+      total_weight += data[i];
+    }
+    const double * moments = data + entry.n + 1;
+    result.set_moments(moments[0], moments[1], total_weight, moments[2]);
+    return result;
+  }
+  SimpleHist hist(const std::string & name) const {return hist(handle(name));}
+
+  /// return the number of entries in histogram h
+  double n_entries(Handle h) const {
+    return _arena[_entries[h].offset + _entries[h].n + 1 + 2];
+  }
+
+  /// set all histograms to zero
+  void reset() {
+    for (std::size_t i = 0; i < _arena_size; i++) _arena[i] = 0.0;
+  }
+
+  /// true if the other bank has the same histograms, declared in the same order
+  bool same_layout(const HistBank & other) const {
+    if (other._entries.size() != _entries.size()) return false;
+    for (unsigned ih = 0; ih < _entries.size(); ih++) {
+      const Entry & a = _entries[ih], & b = other._entries[ih];
+      if (a.name != b.name || a.n != b.n || a.minv != b.minv || a.maxv != b.maxv) return false;
+    }
+    return true;
+  }
+
+  /// merge another bank (with the same layout) into this one
+  HistBank & operator+=(const HistBank & other) {
+    assert(same_layout(other));
+    const double * src = other._arena;
+    for (std::size_t i = 0; i < _arena_size; i++) _arena[i] += src[i];
+    return *this;
+  }
+
+  /// multiply all bins (and the moments of v) by fact; the numbers
+  /// of entries are left unchanged
+  HistBank & operator*=(double fact) {
+    for (unsigned ih = 0; ih < _entries.size(); ih++) {
+      double * data = _arena + _entries[ih].offset;
+      for (unsigned i = 0; i < _entries[ih].n + 1 + 2; i++) data[i] *= fact;
+    }
+    return *this;
+  }
+  HistBank & operator/=(double fact) {return *this *= 1.0/fact;}
+
+  /// write the contents of the bank in binary form, as one block
+  void write_binary(std::ostream & ostr) const {
+    unsigned long long size = _arena_size;
+    ostr.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    ostr.write(reinterpret_cast<const char *>(_arena), _arena_size*sizeof(double));
+  }
+
+  /// read contents written by write_binary for a bank with the same
+  /// declarations; returns false if the sizes do not match
+  bool read_binary(std::istream & istr) {
+    unsigned long long size;
+    istr.read(reinterpret_cast<char *>(&size), sizeof(size));
+    if (!istr || size != _arena_size) return false;
+    istr.read(reinterpret_cast<char *>(_arena), _arena_size*sizeof(double));
+    return bool(istr);
+  }
+
+  /// write all the histograms, each preceded by "# name" and
+  /// followed by two blank lines, as in the tutorials' output files
+  void output(std::ostream & ostr, double norm = 1.0) const {
+    for (unsigned ih = 0; ih < _entries.size(); ih++) {
+      const Entry & entry = _entries[ih];
+      const double * data = _arena + entry.offset;
+      ostr << "# " << entry.name << std::endl;
+      for (unsigned i = 0; i < entry.n; i++) {
+        ostr << i*entry.dv + entry.minv       << " "
+             << (i+0.5)*entry.dv + entry.minv << " "
+             << (i+1)*entry.dv + entry.minv   << " "
+             << data[i]*norm << std::endl;
+      }
+      ostr << std::endl << std::endl;
+    }
+  }
+
+private:
+  /// the moments stored after each histogram's bins: sum of weight*v,
+  /// weight*v*v and the number of entries
+  static const unsigned nmoments = 3;
+  /// number of doubles per cache line
+  static const unsigned line = 64/sizeof(double);
+
+  struct Entry {
+    std::string name;
+    double minv, maxv, dv, inv_dv;
+    unsigned int n;
+    std::size_t offset;
+  };
+
+  static std::size_t _padded(std::size_t n) {return (n + line - 1)/line * line;}
+
+  /// (re)allocate the arena, zeroed, with size n (in doubles)
+  void _allocate(std::size_t n) {
+    std::free(_arena);
+    _arena = 0;
+    _arena_size = n;
+    if (n == 0) return;
+    void * ptr;
+    if (posix_memalign(&ptr, 64, n*sizeof(double)) != 0) {
+      std::cerr << "HistBank: could not allocate " << n << " bins" << std::endl;
+      exit(-1);
+    }
+    _arena = static_cast<double *>(ptr);
+    for (std::size_t i = 0; i < n; i++) _arena[i] = 0.0;
+  }
+
+  std::vector<Entry>            _entries;
+  std::map<std::string,Handle>  _handles;
+  double *                      _arena;
+  std::size_t                   _arena_size;
+};
+
+inline std::ostream & operator<<(std::ostream & ostr, const HistBank & bank) {
+  bank.output(ostr);
+  return ostr;
+}
+
+#endif // __HISTBANK_HH__
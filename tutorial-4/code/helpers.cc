@@ -1,37 +1,29 @@
 #include "helpers.hh"
 
-/// make all long-lived B-hadrons stable
-void set_bflavour_stable(Pythia8::Pythia & pythia) {
-    set_stable(pythia, 5);
-
-    set_stable(pythia, 511);
-    set_stable(pythia, 521);
-    set_stable(pythia, 531);
-    set_stable(pythia, 541);
-    set_stable(pythia, 551);
+namespace {
+  ParticleSettings make_bflavour_stable_settings() {
+    static const int ids[] = {
+      5,
+      511, 521, 531, 541, 551,
+      5122, 5132, 5142, 5232, 5242, 5332, 5342, 5412, 5414, 5422,
+      5424, 5432, 5434, 5442, 5444, 5514, 5522, 5524, 5532, 5534,
+      5542, 5544, 5554};
+    ParticleSettings settings;
+    for (unsigned i = 0; i < sizeof(ids)/sizeof(ids[0]); i++) {
+      settings.set_may_decay(ids[i], false);
+    }
+    return settings;
+  }
+}
 
-    set_stable(pythia, 5122);
-    set_stable(pythia, 5132);
-    set_stable(pythia, 5142);
-    set_stable(pythia, 5232);
-    set_stable(pythia, 5242);
-    set_stable(pythia, 5332);
-    set_stable(pythia, 5342);
-    set_stable(pythia, 5412);
-    set_stable(pythia, 5414);
-    set_stable(pythia, 5422);
-    set_stable(pythia, 5424);
-    set_stable(pythia, 5432);
-    set_stable(pythia, 5434);
-    set_stable(pythia, 5442);
-    set_stable(pythia, 5444);
-    set_stable(pythia, 5514);
-    set_stable(pythia, 5522);
-    set_stable(pythia, 5524);
-    set_stable(pythia, 5532);
-    set_stable(pythia, 5534);
-    set_stable(pythia, 5542);
-    set_stable(pythia, 5544);
-    set_stable(pythia, 5554);
+/// return the settings that make b quarks and all long-lived
+/// B-hadrons stable (built once and then cached)
+const ParticleSettings & bflavour_stable_settings() {
+  static const ParticleSettings settings = make_bflavour_stable_settings();
+  return settings;
+}
 
+/// make all long-lived B-hadrons stable
+void set_bflavour_stable(Pythia8::Pythia & pythia) {
+  bflavour_stable_settings().apply(pythia);
 }
@@ -11,7 +11,12 @@
 #include "Pythia8/FJcore.h"  // subset of FastJet clustering
 #include "helpers.hh"
 #include "AverageAndError.hh"
+#include "CovarianceAccumulator.hh"
+#include "EarlyVeto.hh"
+#include "EventView.hh"
 #include "SimpleHist.hh"
+#include "HistBank.hh"
+#include "BootstrapHist.hh"
 #include "CmdLine.hh"
 // slightly extended version of Pythia8Plugins/FastJet3.h, adapted to fjcore
 // rather than FastJet
@@ -21,6 +26,30 @@ using namespace Pythia8;
 using namespace std;
 using namespace fjcore;
 
+/// cut for the early veto: keep only events with a final-state muon
+/// in the same acceptance as in the analysis below (which is
+/// equivalent to the analysis's muon requirement as long as
+/// hadronisation is off, since there are then no muons from hadron
+/// decays)
+class MuonInAcceptance : public EarlyVetoCut {
+public:
+  MuonInAcceptance(double ptmin, double ymax) : _ptmin(ptmin), _ymax(ymax) {}
+  bool pass(const Pythia8::Event & event) const {
+    return EventView(event).has(13, _ptmin, _ymax);
+  }
+  string description() const {return "muon in acceptance";}
+private:
+  double _ptmin, _ymax;
+};
+
+/// the middle of the highest bin of hist (excluding the outflow)
+double peak_position(const SimpleHist & hist) {
+  unsigned ipeak = 0;
+  for (unsigned i = 1; i < hist.size(); i++) {
+    if (hist[i] > hist[ipeak]) ipeak = i;
+  }
+  return hist.binmid(ipeak);
+}
 
 int main(int argc, char ** argv) {
   // A simple command-line processor
@@ -32,8 +61,20 @@ int main(int argc, char ** argv) {
   double R     = cmdline.value("-R", 0.4);
   double ptmin = cmdline.value("-ptmin", 20.0);
   double ymax  = cmdline.value("-ymax", 2.5);
+  // if on, events without a muon in acceptance are vetoed before
+  // hadronisation (see EarlyVeto.hh); this is off by default, since
+  // the vetoed events then no longer count towards nEvents, which
+  // changes the normalisation of the histograms
+  string early_veto_opt = cmdline.value<string>("-early-veto", "off");
+  // the number of bootstrap replicas for the top-candidate mass
+  int nbootstrap = cmdline.value("-nbootstrap", 100);
 
   cmdline.assert_all_options_used();
+
+  if (nbootstrap < 2) {
+    cerr << "-nbootstrap must be at least 2 (got " << nbootstrap << ")" << endl;
+    exit(-1);
+  }
   
   // Generator. Process selection. LHC initialization. Histogram.
   Pythia pythia;
@@ -63,59 +104,89 @@ int main(int argc, char ** argv) {
   pythia.readString("PartonLevel:MPI = off      ");
     
   
+  // veto the events that the analysis will reject as early as possible
+  MuonInAcceptance muon_in_acceptance(ptmin, ymax);
+  EarlyVeto early_veto;
+  if (early_veto_opt == "on") {
+    early_veto.set_parton_cut(&muon_in_acceptance);
+    pythia.setUserHooksPointer(&early_veto);
+  }
+
   // by changing the seed you can get different events
   pythia.readString("Random:setSeed = on");
   pythia.readString("Random:seed    = 20");
 
   pythia.init();
   
-  // sets up the use of the jet-finding parameters
+  // sets up the use of the jet-finding parameters; the recombiner
+  // adds up the flavour of the particles as they are clustered
   JetDefinition jet_def(antikt_algorithm, R);
+  FlavourRecombiner flavour_recombiner;
+  jet_def.set_recombiner(&flavour_recombiner);
   Selector jet_selector = SelectorPtMin(ptmin) && SelectorAbsRapMax(ymax);
 
-  // these will help us separate out different kinds of particles;
-  // We will ignore all neutrinos
-  Selector neutrino_selector = SelectorIsLepton() && SelectorIsNeutral();
+  // histograms for later, all held in one bank (and written out in
+  // the order in which they are declared here)
+  HistBank hists;
+  HistBank::Handle jet_multiplicity
+    = hists.declare("jet multiplicity (col2 = njets, col4 = nevents)", -0.5, 12.5, 1.0);
+  HistBank::Handle bjet_multiplicity
+    = hists.declare("bjet multiplicity (col2 = njets, col4 = nevents)", -0.5, 12.5, 1.0);
+  HistBank::Handle W_candidate_mass
+    = hists.declare("W candidate mass", 0.0, 150.0, 2.0);
+  // the top candidate mass is also filled for nbootstrap bootstrap
+  // replicas, to get the statistical uncertainty on its peak position
+  BootstrapWeights bootstrap(nbootstrap);
+  BootstrapHist top_candidate_mass(0.0, 300.0, 4.0, bootstrap.nreplicas());
 
-  // and pull out the hardest muon within acceptance (assume the same
-  // acceptance as for the jets)
-  Selector hardest_muon = SelectorNHardest(1) * SelectorId(13) * jet_selector;
-
-  // histograms for later
-  SimpleHist jet_multiplicity  (-0.5, 12.5, 1.0);
-  SimpleHist bjet_multiplicity (-0.5, 12.5, 1.0);
-  SimpleHist W_candidate_mass  (0.0, 150.0, 2.0);
-  SimpleHist top_candidate_mass(0.0, 300.0, 4.0);
+  // correlations between event-level observables, for events
+  // with a W and a top candidate
+  vector<string> event_obs_names;
+  event_obs_names.push_back("multiplicity");
+  event_obs_names.push_back("njets");
+  event_obs_names.push_back("nbjets");
+  event_obs_names.push_back("mW");
+  event_obs_names.push_back("mtop");
+  CovarianceAccumulator event_obs(event_obs_names);
   
+  // the PDG ids and flavours of the particles in each event (reused
+  // from one event to the next)
+  vector<int>           event_ids;
+  vector<PackedFlavour> event_flavours;
+
   // Begin event loop. Generate event. Skip if error. List first one.
   for (int iEvent = 0; iEvent < nEvents; ++iEvent) {
     if (iEvent%100 == 0) cout << iEvent << endl;
     
     if (!pythia.next()) continue;
+    // the bootstrap replica weights for this event
+    bootstrap.set_event(iEvent);
 
-    vector<PseudoJet> particles;
-    
-    // Add an entry to the rapidity histogram for each particle
-    for (int i = 0; i < pythia.event.size(); ++i) {
-      // consider only final-state particles
-      if (!pythia.event[i].isFinal()) continue;
-      particles.push_back(PseudoJet(pythia.event[i]));
-    }
+    // a view of the final-state particles, which lets us apply the
+    // event-level cuts before converting any particles to PseudoJets
+    EventView view(pythia.event);
 
     // having engineered Pythia top decays to be semi-leptonic, we
-    // will now attempt to selector out the neutrinos and the hardest
-    // muon
-    vector<PseudoJet> hadrons, muons, neutrinos, not_neutrinos;
-    PseudoJet muon;
-
-    // FastJet selectors' "sift" function separates out particles
-    // into the ones that do and don't satisfy the condition
-    neutrino_selector.sift(particles, neutrinos, not_neutrinos);
-    hardest_muon.sift(not_neutrinos, muons, hadrons);
+    // will now attempt to pull out the hardest muon within
+    // acceptance (assume the same acceptance as for the jets)
+    int imuon = view.hardest(13, ptmin, ymax);
 
     // if we don't have a muon, then skip this event
-    if (muons.size() < 1) continue;
-    muon = muons[0];
+    if (imuon < 0) continue;
+    PseudoJet muon(pythia.event[imuon]);
+
+    // the particles to be clustered are all the others except the
+    // neutrinos, which we ignore. Their flavours are decoded for the
+    // whole event in one go, and each one is given just its flavour
+    // as user info, which is all that the b-tagging below needs
+    decode_event_flavours(pythia.event, event_ids, event_flavours);
+    vector<PseudoJet> hadrons;
+    for (unsigned j = 0; j < view.final_indices().size(); j++) {
+      int i = view.final_indices()[j];
+      const Particle & p = pythia.event[i];
+      if (i == imuon || (p.isLepton() && p.isNeutral())) continue;
+      hadrons.push_back(flavoured_pseudojet(p, event_flavours[i]));
+    }
 
     // Cluster particle into jets; for hadron collider algorithms it's easiest
     // to use the jet def operator(), which automatically applies the "inclusive"
@@ -129,25 +200,20 @@ int main(int argc, char ** argv) {
     jets = jet_selector(jets);
 
     // record the number of jets that are left
-    jet_multiplicity.add_entry(jets.size());
+    hists.add_entry(jet_multiplicity, jets.size());
 
-    // identify b-jets as being any jet that contains a b-hadron
+    // identify b-jets as being any jet with at least one constituent
+    // that has non-zero b-flavour (counted during the clustering by
+    // the flavour_recombiner)
     vector<PseudoJet> bjets, non_bjets;
     for (unsigned i = 0; i < jets.size(); i++) {
-      // we will look through the constituents of each jet
-      vector<PseudoJet> constituents = jets[i].constituents();
-      // and count the number that have non-zero b-flavour
-      int nb = 0;
-      for (unsigned j = 0; j < constituents.size(); j++) {
-        if (constituents[j].user_info<Py8Particle>().flavour()[5] != 0) nb++;
-      }
-      if (nb != 0) {
+      if (n_flavoured_constituents(jets[i], 5) > 0) {
         bjets.push_back(jets[i]);
       } else {
         non_bjets.push_back(jets[i]);
       }
     }
-    bjet_multiplicity.add_entry(bjets.size());
+    hists.add_entry(bjet_multiplicity, bjets.size());
 
 
     // We expect a b from the top and two non-bjets from the W.
@@ -156,16 +222,24 @@ int main(int argc, char ** argv) {
 
     // now try to reconstruct a W candidate
     PseudoJet W_candidate = non_bjets[0] + non_bjets[1];
-    W_candidate_mass.add_entry(W_candidate.m());
+    hists.add_entry(W_candidate_mass, W_candidate.m());
     // then a top candidate, by combining the W with each of the b jets
     // in sequence
     for (unsigned ib = 0; ib < bjets.size(); ib++) {
       PseudoJet top_candidate = W_candidate + bjets[ib];
-      top_candidate_mass.add_entry(top_candidate.m());
+      top_candidate_mass.add_entry(top_candidate.m(), bootstrap);
     }
 
+    // the top candidate with the hardest b-jet enters the correlations
+    double obs[] = {double(view.n_final()), double(jets.size()), double(bjets.size()),
+                    W_candidate.m(), (W_candidate + bjets[0]).m()};
+    event_obs.add(obs);
+
   }
   pythia.stat();
+  early_veto.report(cout);
+  // report any particle ids whose flavour could not be decoded
+  FlavourHolder::print_unknown_summary(cout);
 
 
   // now write the output
@@ -176,17 +250,22 @@ int main(int argc, char ** argv) {
   file << "# " << cmdline.command_line() << endl;
   file << "# jet_definition = " << jet_def.description() << endl;
   file << "# jet_selector   = " << jet_selector.description() << endl;
-  
-  file << "# jet multiplicity (col2 = njets, col4 = nevents)" << endl;
-  file << jet_multiplicity << endl << endl;
-
-  file << "# bjet multiplicity (col2 = njets, col4 = nevents)" << endl;
-  file << bjet_multiplicity << endl << endl;
+  early_veto.report(file, "# ");
+  event_obs.output_correlations(&file, "# ");
+  // the peak of the top candidate mass, with its uncertainty from the
+  // spread across the bootstrap replicas
+  AverageAndError replica_peaks;
+  for (unsigned r = 0; r < top_candidate_mass.nreplicas(); r++) {
+    replica_peaks += peak_position(top_candidate_mass.replica(r));
+  }
+  file << "# top candidate mass peak = " << peak_position(top_candidate_mass.nominal())
+       << " +- " << replica_peaks.sd() << " (bootstrap, "
+       << top_candidate_mass.nreplicas() << " replicas)" << endl;
 
-  file << "# W candidate mass" << endl;
-  file << W_candidate_mass << endl << endl;
+  // all the histograms, each preceded by its name
+  file << hists;
 
-  file << "# top candidate mass" << endl;
+  file << "# top candidate mass (col4 = nevents, col5 = bootstrap spread)" << endl;
   file << top_candidate_mass << endl << endl;
 
   return 0;
@@ -62,6 +62,21 @@
 /// FastJet selectors using standard boolean operators.  They are all
 /// in the fastjet namespace.
 ///
+/// To obtain the flavour content of jets, cluster with a
+/// FlavourRecombiner, which adds up the flavour of the particles at
+/// each recombination step, together with the number of particles
+/// that carry each flavour,
+///
+/// \code
+///   FlavourRecombiner flavour_recombiner;
+///   jet_def.set_recombiner(&flavour_recombiner);
+///   ...
+///   bool is_bjet = (n_flavoured_constituents(jet, 5) > 0);
+///   int net_b    = jet_flavour(jet)[5];
+/// \endcode
+///
+/// Note that a jet with a b and a bbar has zero net b-flavour.
+///
 /// If you do not need the above facilities, then you may instead
 /// construct the PseudoJet from the pythia8 particle's 4-vector
 ///
@@ -102,6 +117,109 @@ private:
   FlavourHolder _flavour;
 };
 
+/// \class FlavourInfo
+///
+/// User info holding the net flavour content of a PseudoJet that
+/// results from a recombination with a FlavourRecombiner (or of a
+/// particle made with flavoured_pseudojet), and, for each flavour,
+/// the number of its constituents with a non-zero content of that
+/// flavour
+class FlavourInfo: public PseudoJet::UserInfoBase {
+public:
+  FlavourInfo(const PackedFlavour & flavour) : _flavour(flavour) {
+    for (int iflv = 0; iflv <= 6; iflv++) _n_flavoured[iflv] = 0;
+  }
+  const PackedFlavour & flavour() const {return _flavour;}
+
+  /// the number of constituents with non-zero content of flavour
+  /// iflv (d=1, u=2, s=3, c=4, b=5, t=6)
+  int n_flavoured(int iflv) const {return _n_flavoured[iflv];}
+  void set_n_flavoured(int iflv, int n) {_n_flavoured[iflv] = n;}
+private:
+  PackedFlavour _flavour;
+  int _n_flavoured[7];
+};
+
+/// return the net flavour content of a PseudoJet: that of the Pythia8
+/// particle, or, for a jet clustered with a FlavourRecombiner, the
+/// sum over its constituents (zero if neither is available)
+inline PackedFlavour jet_flavour(const PseudoJet & jet) {
+  const PseudoJet::UserInfoBase * info = jet.user_info_ptr();
+  if (info == 0) return PackedFlavour();
+  const FlavourInfo * flav_info = dynamic_cast<const FlavourInfo *>(info);
+  if (flav_info) return flav_info->flavour();
+  const Py8Particle * particle = dynamic_cast<const Py8Particle *>(info);
+  if (particle) return PackedFlavour(particle->flavour());
+  return PackedFlavour();
+}
+
+/// return the number of constituents of a PseudoJet with non-zero
+/// content of flavour iflv: for a Pythia8 particle, 1 or 0, and, for
+/// a jet clustered with a FlavourRecombiner, the sum over its
+/// constituents (zero if neither is available)
+inline int n_flavoured_constituents(const PseudoJet & jet, int iflv) {
+  const PseudoJet::UserInfoBase * info = jet.user_info_ptr();
+  if (info == 0) return 0;
+  const FlavourInfo * flav_info = dynamic_cast<const FlavourInfo *>(info);
+  if (flav_info) return flav_info->n_flavoured(iflv);
+  const Py8Particle * particle = dynamic_cast<const Py8Particle *>(info);
+  if (particle) return (particle->flavour()[iflv] != 0) ? 1 : 0;
+  return 0;
+}
+
+/// return a PseudoJet with the momentum of the Pythia8 particle and a
+/// FlavourInfo with the given flavour content (e.g. from
+/// decode_pdg_ids) as user info. This is cheaper to make than a
+/// PseudoJet with a Py8Particle, and is all that a FlavourRecombiner
+/// needs.
+inline PseudoJet flavoured_pseudojet(const Pythia8::Particle & particle,
+                                     const PackedFlavour & flavour) {
+  PseudoJet result(particle.px(), particle.py(), particle.pz(), particle.e());
+  FlavourInfo * info = new FlavourInfo(flavour);
+  for (int iflv = 1; iflv <= 6; iflv++) {
+    info->set_n_flavoured(iflv, (flavour[iflv] != 0) ? 1 : 0);
+  }
+  result.set_user_info(info);
+  return result;
+}
+
+/// \class FlavourRecombiner
+///
+/// A recombiner that combines momenta like the default recombiner
+/// (with the given scheme), and that sets the user info of each
+/// recombined PseudoJet to a FlavourInfo with the sum of the net
+/// flavour contents of the two PseudoJets being merged (and of their
+/// numbers of flavoured constituents). After clustering,
+/// jet_flavour(jet) and n_flavoured_constituents(jet, iflv) then give
+/// the jet's flavour information without having to go through its
+/// constituents.
+///
+/// The recombiner must remain in existence for as long as the jet
+/// definition that uses it.
+class FlavourRecombiner : public JetDefinition::Recombiner {
+public:
+  FlavourRecombiner(RecombinationScheme scheme = E_scheme) : _default(scheme) {}
+
+  std::string description() const {
+    return _default.description() + ", with flavour accumulation";
+  }
+
+  void recombine(const PseudoJet & pa, const PseudoJet & pb, PseudoJet & pab) const {
+    // NB: the default recombination resets pab's user info, so the
+    // flavour must be set afterwards
+    FlavourInfo * info = new FlavourInfo(jet_flavour(pa) + jet_flavour(pb));
+    for (int iflv = 1; iflv <= 6; iflv++) {
+      info->set_n_flavoured(iflv, n_flavoured_constituents(pa, iflv)
+                                  + n_flavoured_constituents(pb, iflv));
+    }
+    _default.recombine(pa, pb, pab);
+    pab.set_user_info(info);
+  }
+
+private:
+  JetDefinition::DefaultRecombiner _default;
+};
+
 /// specialization of the PseudoJet constructor so that it can take a
 /// pythia8 particle (and makes a copy of it as user info);
 template<>
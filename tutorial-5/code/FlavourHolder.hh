@@ -28,6 +28,11 @@
 //ENDHEADER
 
 #include<vector>
+#include<map>
+#include<iosfwd>
+#include<cstdlib>
+#include<cstddef>
+#include<stdint.h>
 
 //----------------------------------------------------------------------
 /// Class that holds the flavour of an object in a form that
@@ -35,12 +40,22 @@
 ///
 /// NB: particle numbering is given at http://www-cpd.fnal.gov/psm/stdhep/
 ///
+/// Particles whose idhep is not understood (e.g. some excited states)
+/// are given zero flavour content and is_known() = false, rather than
+/// stopping the program; the number of times each such idhep was seen
+/// is recorded and can be printed at the end of the run with
+/// FlavourHolder::print_unknown_summary().
+///
 class FlavourHolder {
 
 public:
   /// initialise the FlavourHolder from a standard idhep value
   FlavourHolder(int idhep);
 
+  /// false if the idhep was not understood (in which case the
+  /// flavour content is zero)
+  bool is_known() const;
+
   /// return the amount of a given quark flavour (d=1, u=2, s=3, c=4, b=5, t=6)
   const int operator[] (int) const;
 
@@ -60,15 +75,108 @@ public:
   /// return the electric charge in units of e; currently does not 
   /// not do gauge bosons properly
   double charge() const; 
+
+  /// set flav_content[1..6] (which must be zero on entry) to the net
+  /// quark content of the particle labelled by idhep; returns false
+  /// if idhep is not understood
+  static bool decode(int idhep, int * flav_content);
+
+  /// record an occurrence of an idhep that was not understood (the
+  /// first occurrence of each idhep also gives a warning)
+  static void record_unknown(int idhep);
+  /// return the number of occurrences of each idhep that was not
+  /// understood
+  static std::map<int,uint64_t> unknown_counts();
+  /// print a summary of the idheps that were not understood (nothing
+  /// is printed if there were none)
+  static void print_unknown_summary(std::ostream & ostr);
+  static void print_unknown_summary();
   
 private:
   
   std::vector<int> _flav_content;
   int              _idhep;
+  bool             _known;
 };
 
 
+//----------------------------------------------------------------------
+/// Class that holds the net quark-flavour content of a particle or of a
+/// set of particles (e.g. a jet) packed into a single 64-bit word, with
+/// 10 bits per flavour, so that the content of a set of particles can
+/// be accumulated with one integer addition per particle.
+///
+/// Each flavour's net content must stay in the range -512..511.
+class PackedFlavour {
+public:
+  /// zero flavour content
+  PackedFlavour() : _packed(0) {}
+  /// the flavour content of the given FlavourHolder
+  PackedFlavour(const FlavourHolder & flav);
+
+  /// return the net amount of a given quark flavour (d=1, u=2, s=3, c=4, b=5, t=6)
+  int operator[] (int iflv) const;
+
+  /// add the flavour content of other
+  PackedFlavour & operator+=(const PackedFlavour & other) {
+    _packed += other._packed; return *this;}
+  /// subtract the flavour content of other
+  PackedFlavour & operator-=(const PackedFlavour & other) {
+    _packed -= other._packed; return *this;}
+
+  /// true if the net content of all flavours is zero
+  bool is_flavourless() const {return _packed == 0;}
+
+  /// return the packed word
+  uint64_t packed() const {return _packed;}
+  /// return the PackedFlavour with the given packed word
+  static PackedFlavour from_packed(uint64_t packed) {
+    PackedFlavour result; result._packed = packed; return result;}
+
+private:
+  static const unsigned _bits = 10;
+  static const uint64_t _mask = (uint64_t(1) << _bits) - 1;
+  static const uint64_t _half = uint64_t(1) << (_bits-1);
+  // flavour iflv (1..6) is held in bits (iflv-1)*_bits upwards, as
+  // a sum of content * 2^((iflv-1)*_bits), so that the packed words
+  // add like the contents (negative contents borrow from the higher
+  // flavours, which is undone when unpacking)
+  uint64_t _packed;
+};
+
+inline PackedFlavour operator+(PackedFlavour a, const PackedFlavour & b) {
+  a += b; return a;}
+
+/// decode the n PDG ids in ids[] in one go, setting flavours[i] to the
+/// net flavour content of particle i and (if charges is non-null)
+/// charges[i] to its charge, with the same conventions as
+/// FlavourHolder and FlavourHolder::charge(), including for ids that
+/// are not understood. The information is taken from a table of
+/// precomputed ids, built on first use.
+void decode_pdg_ids(const int * ids, std::size_t n,
+                    PackedFlavour * flavours, double * charges = 0);
+
+
 //-----  inline material ------------------------------------------------
+inline PackedFlavour::PackedFlavour(const FlavourHolder & flav) : _packed(0) {
+  for (int iflv = 6; iflv >= 1; iflv--) {
+    _packed = (_packed << _bits) + uint64_t(int64_t(flav[iflv]));
+  }
+}
+
+inline int PackedFlavour::operator[] (int iflv) const {
+  uint64_t word = _packed;
+  for (int i = 1; ; i++) {
+    // the sign-extended content of the lowest flavour left in word
+    int64_t content = int64_t(word & _mask);
+    if (content >= int64_t(_half)) content -= int64_t(_mask + 1);
+    if (i == iflv) return int(content);
+    word = (word - uint64_t(content)) >> _bits;
+  }
+}
+
+inline bool FlavourHolder::is_known() const {return _known;}
+
 inline const int FlavourHolder::operator[] (int iflv) const {
   return _flav_content[iflv];
 }
@@ -0,0 +1,238 @@
+#ifndef __MULTIWEIGHTHIST_HH__
+#define __MULTIWEIGHTHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file MultiWeightHist.hh
+///
+/// A histogram that is filled simultaneously with N event weights,
+/// e.g. the nominal weight and a set of scale or shower variations:
+///
+/// \code
+///   MultiWeightHist jet_mass(0.0, 150.0, 2.0, nweights);
+///   ...
+///   // weights points to the nweights weights of this event
+///   jet_mass.add_entry(jet.m(), weights);
+/// \endcode
+///
+/// The bin index is computed once per entry, and the weights are
+/// stored bin by bin, i.e. entry (ibin, iw) is at ibin*N + iw, so that
+/// adding an event's weights is a single contiguous vector addition.
+/// Variation iw can be extracted as a SimpleHist with variation(iw);
+/// the output has one column per variation.
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<valarray>
+#include<vector>
+#include<iostream>
+#include<cassert>
+#include<cstddef>
+#include<algorithm>
+
+class MultiWeightHist {
+public:
+  MultiWeightHist() {};
+
+  MultiWeightHist(double minv, double maxv, double bin_size, unsigned int nweights) {
+    declare(minv, maxv, bin_size, nweights);
+  }
+
+  MultiWeightHist(double minv, double maxv, int n, unsigned int nweights) {
+    declare(minv, maxv, n, nweights);
+  }
+
+  MultiWeightHist(double minv, double maxv, unsigned int n, unsigned int nweights) {
+    declare(minv, maxv, n, nweights);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, double bin_size, unsigned int nweights) {
+    declare(minv, maxv, unsigned(0.5+(maxv-minv)/bin_size), nweights);
+  }
+
+  void declare(double minv, double maxv, int n, unsigned int nweights) {
+    declare(minv, maxv, unsigned(n), nweights);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double minv, double maxv, unsigned int n, unsigned int nweights) {
+    assert(nweights > 0);
+    _minv = minv; _maxv = maxv; _dv = (maxv-minv)/n; _inv_dv = 1.0/_dv;
+    _n = n; _nweights = nweights;
+    _weights.resize((n+1)*nweights);
+    _weight_v.resize(nweights);
+    _weight_vsq.resize(nweights);
+    reset();
+  }
+
+  /// reset the contents of the histogram to zero (does not
+  /// modify the histogram bounds)
+  void reset() {
+    _weights = 0.0;
+    _weight_v = 0.0;
+    _weight_vsq = 0.0;
+    _n_entries = 0.0;
+  }
+
+  double min() const {return _minv;};
+  double max() const {return _maxv;};
+  /// returns the size of the histogram proper
+  unsigned int size() const {return _n;}
+  /// returns the size of the histogram plus outflow bin
+  unsigned int outflow_size() const {return _n+1;}
+  /// returns the number of weights per entry
+  unsigned int nweights() const {return _nweights;}
+
+  /// the content of bin i for weight iw
+  double & operator()(unsigned i, unsigned iw) {return _weights[i*_nweights + iw];}
+  const double & operator()(unsigned i, unsigned iw) const {return _weights[i*_nweights + iw];}
+
+  double binlo (int i) const {return i*_dv + _minv;};
+  double binhi (int i) const {return (i+1)*_dv + _minv;};
+  double binmid(int i) const {return (i+0.5)*_dv + _minv;};
+  double binsize()     const {return _dv;};
+
+  unsigned int bin(double v) const {
+    if (v >= _minv && v < _maxv) {
+      unsigned i = unsigned((v-_minv)*_inv_dv);
+      if (i < _n) return i;
+    }
+    return _n;
+  }
+
+  double n_entries() const {return _n_entries;}
+
+  /// return the mean value for weight iw of all entries, including
+  /// those that were outside the histogram edges
+  double mean(unsigned iw) const {return _weight_v[iw] / total_weight(iw);}
+
+  /// return the total weight iw in the histogram
+  double total_weight(unsigned iw) const {
+    double total = 0.0;
+    for (unsigned i = 0; i <= _n; i++) total += (*this)(i,iw);
+    return total;
+  }
+
+  /// add an entry with value v and weights w[0..nweights()-1]
+  void add_entry(double v, const double * w) {
+    _add_entry(bin(v), v, v*v, w);
+    _n_entries += 1.0;
+  }
+
+  /// add an entry with value v and the weights in w
+  void add_entry(double v, const std::vector<double> & w) {
+    assert(w.size() == _nweights);
+    add_entry(v, &w[0]);
+  }
+
+  /// add n entries with values v[i]; the weights for entry i are in
+  /// w[i*nweights() .. (i+1)*nweights()-1]. The bin indices and v^2
+  /// are computed for a block of entries in a first pass, and the
+  /// weights added in a second.
+  void add_entries(const double * v, std::size_t n, const double * w) {
+    const std::size_t block = 256;
+    unsigned indices[block];
+    double   vsq[block];
+    for (std::size_t start = 0; start < n; start += block) {
+      std::size_t nb = std::min(block, n - start);
+      const double * vb = v + start;
+      for (std::size_t i = 0; i < nb; i++) {
+        indices[i] = bin(vb[i]);
+        vsq[i] = vb[i]*vb[i];
+      }
+      const double * wb = w + start*_nweights;
+      for (std::size_t i = 0; i < nb; i++) {
+        _add_entry(indices[i], vb[i], vsq[i], wb + i*_nweights);
+      }
+    }
+    _n_entries += n;
+  }
+
+  /// add n entries with values v[i] that all have the same set of
+  /// weights w (e.g. several particles or jets from one event)
+  void add_entries_same_weights(const double * v, std::size_t n, const double * w) {
+    for (std::size_t i = 0; i < n; i++) {
+      double * dest = &_weights[bin(v[i])*_nweights];
+      for (unsigned iw = 0; iw < _nweights; iw++) dest[iw] += w[iw];
+    }
+    double sv = 0, svsq = 0;
+    for (std::size_t i = 0; i < n; i++) {sv += v[i]; svsq += v[i]*v[i];}
+    for (unsigned iw = 0; iw < _nweights; iw++) {
+      _weight_v[iw]   += w[iw] * sv;
+      _weight_vsq[iw] += w[iw] * svsq;
+    }
+    _n_entries += n;
+  }
+
+  /// return the histogram for weight iw as a SimpleHist
+  SimpleHist variation(unsigned iw) const {
+    assert(iw < _nweights);
+    SimpleHist result(_minv, _maxv, _n);
+    for (unsigned i = 0; i <= _n; i++) result.set(i, (*this)(i,iw));
+    result.set_moments(_weight_v[iw], _weight_vsq[iw], total_weight(iw), _n_entries);
+    return result;
+  }
+
+  // Operations with constants ---------------------------------------
+  MultiWeightHist & operator*=(double fact) {
+    _weights *= fact;
+    _weight_v *= fact;
+    _weight_vsq *= fact;
+    return *this;
+  };
+  MultiWeightHist & operator/=(double fact) {
+    *this *= 1.0/fact;
+    return *this;
+  };
+
+  // Operations with another histogram -------------------------------
+  MultiWeightHist & operator+=(const MultiWeightHist & other) {
+    assert(other._n == _n && other._nweights == _nweights);
+    _weights += other._weights;
+    _weight_v += other._weight_v;
+    _weight_vsq += other._weight_vsq;
+    _n_entries += other._n_entries;
+    return *this;
+  };
+
+private:
+  /// add the weights w to bin ibin and to the moments, given v and v^2
+  void _add_entry(unsigned ibin, double v, double vsq, const double * w) {
+    double * dest = &_weights[ibin*_nweights];
+    double * wv   = &_weight_v[0];
+    double * wvsq = &_weight_vsq[0];
+    for (unsigned iw = 0; iw < _nweights; iw++) {
+      dest[iw] += w[iw];
+      wv[iw]   += w[iw] * v;
+      wvsq[iw] += w[iw] * vsq;
+    }
+  }
+
+  double _minv, _maxv, _dv, _inv_dv;
+  unsigned int _n, _nweights;
+  std::valarray<double> _weights;
+  std::valarray<double> _weight_v, _weight_vsq;
+  double _n_entries;
+};
+
+/// output the histogram, with columns binlo, binmid, binhi and then
+/// one column per weight; the output is multiplied by the factor norm.
+inline void output(const MultiWeightHist & hist,
+                   std::ostream * ostr = (&std::cout),
+                   double norm = 1.0) {
+  for (unsigned i = 0; i < hist.size(); i++) {
+    *ostr << hist.binlo(i)  << " "
+          << hist.binmid(i) << " "
+          << hist.binhi(i);
+    for (unsigned iw = 0; iw < hist.nweights(); iw++)
+      *ostr << " " << hist(i,iw) * norm;
+    *ostr << std::endl;
+  }
+}
+
+inline std::ostream & operator<<(std::ostream & ostr, const MultiWeightHist & hist) {
+  output(hist, &ostr);
+  return ostr;
+}
+
+#endif // __MULTIWEIGHTHIST_HH__
@@ -0,0 +1,189 @@
+#ifndef __QUANTILESKETCH_HH__
+#define __QUANTILESKETCH_HH__
+
+#include<cmath>
+#include<vector>
+#include<cstddef>
+#include<algorithm>
+#include<stdint.h>
+
+/// micro class to estimate quantiles (median, 99th percentile, etc.)
+/// of a stream of values in a fixed amount of memory, with the same
+/// add/+= interface as AverageAndError, e.g.
+///
+/// \code
+///   QuantileSketch multiplicity_quantiles;
+///   ...
+///   multiplicity_quantiles += particles.size();
+///   ...
+///   file << "# multiplicity p99 = " << multiplicity_quantiles.quantile(0.99) << endl;
+/// \endcode
+///
+/// It is a "merging t-digest" (T. Dunning and O. Ertl,
+/// arXiv:1902.04023): the values are collected in a buffer and, when
+/// it is full, merged with a sorted list of centroids (weighted
+/// means), where the size of the centroids is limited so that those
+/// near the tails of the distribution contain few values; this gives
+/// a relative accuracy on the quantiles that is best near q = 0 and
+/// q = 1. The number of centroids is at most about the compression
+/// parameter (default 100), and the buffer holds 5 times as many
+/// entries, so the memory does not grow with the number of entries.
+/// Sketches from different threads or jobs can be merged with +=.
+/// Entries may carry a (positive) weight, e.g. for weighted events.
+class QuantileSketch {
+public:
+
+  /// constructor, with the compression parameter delta (larger
+  /// values give more accurate quantiles and use more memory)
+  QuantileSketch(double delta = 100.0) : _delta(delta) {
+    _max_centroids = unsigned(std::ceil(delta)) + 2;
+    _max_buffer    = 5 * _max_centroids;
+    _centroids.reserve(_max_centroids);
+    _buffer.reserve(_max_buffer);
+    _scratch.reserve(_max_centroids + _max_buffer);
+    _n = 0;
+    _total_weight = 0.0;
+  }
+
+  /// add one entry, with the given weight
+  inline void add(double x, double weight = 1.0) {
+                              _add_weighted(x, weight); _n += 1;
+                              _total_weight += weight;
+                              if (_n == 1) {_min = x; _max = x;}
+                              else {_min = std::min(_min, x); _max = std::max(_max, x);}
+                            }
+
+  /// add n entries at once
+  inline void add(const double * x, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) add(x[i]);
+  }
+
+  /// add vector with entries
+  inline void add(const std::vector<double> & v) {
+    if (v.size() > 0) add(&v[0], v.size());
+  }
+
+  /// alternative way to add one or more entries, for consistency with
+  /// SimpleHist, AveragingHist, etc
+  inline void add_entry(double x, double weight = 1.0) { add(x, weight); }
+  inline void add_entry(const std::vector<double> & v) { add(v); }
+
+  /// add one event with a different notation
+  inline void operator+= (double x) { add(x); }
+
+  /// merge the entries of another sketch into this one
+  inline QuantileSketch & operator+= (const QuantileSketch & other) {
+    if (other._n == 0) return *this;
+    if (_n == 0) {_min = other._min; _max = other._max;}
+    else {_min = std::min(_min, other._min); _max = std::max(_max, other._max);}
+    for (unsigned i = 0; i < other._centroids.size(); i++)
+      _add_weighted(other._centroids[i].mean, other._centroids[i].weight);
+    for (unsigned i = 0; i < other._buffer.size(); i++)
+      _add_weighted(other._buffer[i].mean, other._buffer[i].weight);
+    _n += other._n;
+    _total_weight += other._total_weight;
+    return *this;
+  }
+
+  /// return number of entries
+  inline int64_t n() const { return _n; }
+  inline int64_t n_entries() const { return n(); }
+  /// return the sum of the weights of the entries
+  inline double total_weight() const { return _total_weight; }
+
+  /// return the smallest and largest entries
+  inline double min() const { return _min; }
+  inline double max() const { return _max; }
+
+  /// return the estimate of the q quantile (0 <= q <= 1), e.g. q =
+  /// 0.5 for the median; it is zero if there are no entries
+  inline double quantile(double q) const {
+    if (_n == 0) return 0.;
+    _compress();
+    // each centroid is taken to sit at the middle of its cumulative
+    // weight, and we interpolate linearly between them (and the
+    // smallest and largest entries at the ends)
+    double target = std::min(std::max(q, 0.0), 1.0) * _total_weight;
+    double cumul = 0.0, prev_pos = 0.0, prev_mean = _min;
+    for (unsigned i = 0; i < _centroids.size(); i++) {
+      double pos = cumul + 0.5 * _centroids[i].weight;
+      if (target < pos) {
+        return prev_mean + (_centroids[i].mean - prev_mean) * (target - prev_pos)/(pos - prev_pos);
+      }
+      cumul += _centroids[i].weight;
+      prev_pos = pos; prev_mean = _centroids[i].mean;
+    }
+    if (cumul <= prev_pos) return _max;
+    return prev_mean + (_max - prev_mean) * (target - prev_pos)/(cumul - prev_pos);
+  }
+
+  /// return the estimate of the median
+  inline double median() const { return quantile(0.5); }
+
+  /// return the number of centroids currently held (after merging in
+  /// the buffer)
+  inline unsigned size() const { _compress(); return _centroids.size(); }
+
+private:
+  struct Centroid {
+    double mean, weight;
+    bool operator<(const Centroid & other) const {return mean < other.mean;}
+  };
+
+  inline void _add_weighted(double x, double w) {
+    Centroid c = {x, w};
+    _buffer.push_back(c);
+    if (_buffer.size() >= _max_buffer) _compress();
+  }
+
+  /// the t-digest scale function k1(q) and its inverse
+  inline double _k(double q) const { return _delta/(2*M_PI) * std::asin(2*q - 1); }
+  inline double _q(double k) const {
+    if (k >= _delta/4) return 1.0;
+    return 0.5 * (std::sin(k * 2*M_PI/_delta) + 1);
+  }
+
+  /// merge the buffer into the centroids
+  inline void _compress() const {
+    if (_buffer.size() == 0) return;
+    _scratch.assign(_centroids.begin(), _centroids.end());
+    _scratch.insert(_scratch.end(), _buffer.begin(), _buffer.end());
+    _buffer.clear();
+    std::sort(_scratch.begin(), _scratch.end());
+
+    double total = 0.0;
+    for (unsigned i = 0; i < _scratch.size(); i++) total += _scratch[i].weight;
+
+    // go through the sorted entries, merging each into the current
+    // centroid as long as the latter stays within one unit of k
+    _centroids.clear();
+    Centroid current = _scratch[0];
+    double q0 = 0.0;
+    double q_limit = _q(_k(q0) + 1);
+    for (unsigned i = 1; i < _scratch.size(); i++) {
+      const Centroid & c = _scratch[i];
+      double q_new = q0 + (current.weight + c.weight)/total;
+      if (q_new <= q_limit) {
+        current.weight += c.weight;
+        current.mean   += (c.mean - current.mean) * c.weight / current.weight;
+      } else {
+        _centroids.push_back(current);
+        q0 += current.weight/total;
+        q_limit = _q(_k(q0) + 1);
+        current = c;
+      }
+    }
+    _centroids.push_back(current);
+  }
+
+  double _delta;
+  unsigned _max_centroids, _max_buffer;
+  // mutable so that the buffer can be merged in when quantiles are
+  // requested
+  mutable std::vector<Centroid> _centroids, _buffer, _scratch;
+  int64_t _n;
+  double _total_weight;
+  double _min, _max;
+};
+
+#endif // __QUANTILESKETCH_HH__
@@ -0,0 +1,301 @@
+#ifndef __SHAREDHIST_HH__
+#define __SHAREDHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file SharedHist.hh
+///
+/// Tools for making the current state of a set of SimpleHists visible
+/// to other processes while a job is running, via a POSIX
+/// shared-memory segment. In the job one writes
+///
+/// \code
+///   SharedHistWriter shared_hists;
+///   shared_hists.add("jet mass", jet_mass);
+///   shared_hists.open("/main01");
+///   ...
+///   // every so often in the event loop
+///   shared_hists.publish(iEvent);
+/// \endcode
+///
+/// and an external program (e.g. histmon) can then use a
+/// SharedHistReader to attach to "/main01" and get a copy of the
+/// histograms as they were at the last publish() call.
+///
+/// The segment consists of a small header (a SharedHistHeader), one
+/// SharedHistLayout per histogram, and then the bin contents
+/// (including the outflow bin) and number of entries of each
+/// histogram, as doubles.
+///
+/// Consistency between the writer and readers is ensured with a
+/// sequence number (a "seqlock"): the writer makes it odd while it
+/// copies the histograms in and even once it is done; readers retry
+/// if the number was odd or changed while they were copying out. So
+/// the writer never waits for a reader, and nothing at all is done
+/// when filling the histograms. Readers give up after a timeout, so
+/// that a writer that died in the middle of an update (leaving the
+/// number odd) does not make them wait forever.
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<atomic>
+#include<new>
+#include<string>
+#include<vector>
+#include<cstring>
+#include<iostream>
+#include<stdint.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+
+/// the header at the start of the shared-memory segment
+struct SharedHistHeader {
+  char     magic[8];       ///< "SIMPHIST"
+  uint32_t version;
+  uint32_t nhist;          ///< number of histograms in the segment
+  uint64_t data_offset;    ///< offset (bytes) of the bin contents
+  uint64_t total_size;     ///< size (bytes) of the whole segment
+  std::atomic<uint64_t> sequence; ///< odd while an update is in progress
+  uint64_t nevents;        ///< number of events at last update
+};
+
+/// the description of one histogram in the segment
+struct SharedHistLayout {
+  char     name[64];
+  double   minv, maxv;
+  uint32_t nbins;          ///< number of bins, excluding the outflow bin
+  uint32_t unused;
+  uint64_t offset;         ///< offset (in doubles) from start of data
+};
+
+const uint32_t shared_hist_version = 1;
+
+//----------------------------------------------------------------------
+/// Class that copies a set of histograms into a POSIX shared-memory
+/// segment each time publish() is called.
+class SharedHistWriter {
+public:
+  SharedHistWriter() : _header(0), _size(0) {}
+  ~SharedHistWriter() {close();}
+
+  /// register a histogram; must be called before open(). The
+  /// histogram must remain in scope (and not be redeclared) for as
+  /// long as the writer is active.
+  void add(const std::string & name, const SimpleHist & hist) {
+    assert(_header == 0);
+    _names.push_back(name);
+    _hists.push_back(&hist);
+  }
+
+  /// create the segment (e.g. "/main01") and write the layout into it;
+  /// returns false (with a warning) if the segment could not be
+  /// created, in which case subsequent publish() calls do nothing.
+  bool open(const std::string & segment_name) {
+    _segment_name = segment_name;
+
+    // work out the layout
+    std::size_t ndata = 0;
+    std::vector<SharedHistLayout> layouts(_hists.size());
+    for (unsigned ih = 0; ih < _hists.size(); ih++) {
+      SharedHistLayout & layout = layouts[ih];
+      std::memset(&layout, 0, sizeof(layout));
+      std::strncpy(layout.name, _names[ih].c_str(), sizeof(layout.name)-1);
+      layout.minv   = _hists[ih]->min();
+      layout.maxv   = _hists[ih]->max();
+      layout.nbins  = _hists[ih]->size();
+      layout.offset = ndata;
+      // bins + outflow + n_entries
+      ndata += _hists[ih]->outflow_size() + 1;
+    }
+    std::size_t data_offset = sizeof(SharedHistHeader)
+                            + layouts.size() * sizeof(SharedHistLayout);
+    // keep the doubles aligned
+    data_offset = (data_offset + 7) & ~std::size_t(7);
+    _size = data_offset + ndata * sizeof(double);
+
+    int fd = shm_open(segment_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+      std::cerr << "SharedHistWriter: could not create shared-memory segment "
+                << segment_name << "; histograms will not be published" << std::endl;
+      return false;
+    }
+    if (ftruncate(fd, _size) != 0) {
+      std::cerr << "SharedHistWriter: could not size shared-memory segment "
+                << segment_name << std::endl;
+      ::close(fd); shm_unlink(segment_name.c_str());
+      return false;
+    }
+    void * addr = mmap(0, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      std::cerr << "SharedHistWriter: could not map shared-memory segment "
+                << segment_name << std::endl;
+      shm_unlink(segment_name.c_str());
+      return false;
+    }
+
+    // fill in the header and layouts (the segment starts out zeroed)
+    _header = new (addr) SharedHistHeader;
+    std::memcpy(_header->magic, "SIMPHIST", 8);
+    _header->version     = shared_hist_version;
+    _header->nhist       = _hists.size();
+    _header->data_offset = data_offset;
+    _header->total_size  = _size;
+    _header->nevents     = 0;
+    if (layouts.size() > 0) std::memcpy(static_cast<void *>(_header + 1), &layouts[0],
+                                 layouts.size() * sizeof(SharedHistLayout));
+    _data    = reinterpret_cast<double *>(static_cast<char *>(addr) + data_offset);
+    _offsets.resize(layouts.size());
+    for (unsigned ih = 0; ih < layouts.size(); ih++) _offsets[ih] = layouts[ih].offset;
+    _header->sequence.store(0, std::memory_order_release);
+    return true;
+  }
+
+  /// true if the segment has been successfully opened
+  bool active() const {return _header != 0;}
+
+  /// copy the current contents of all histograms into the segment
+  void publish(uint64_t nevents) {
+    if (!active()) return;
+    uint64_t seq = _header->sequence.load(std::memory_order_relaxed);
+    _header->sequence.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (unsigned ih = 0; ih < _hists.size(); ih++) {
+      const SimpleHist & hist = *_hists[ih];
+      double * dest = _data + _offsets[ih];
+      for (unsigned i = 0; i < hist.outflow_size(); i++) dest[i] = hist[i];
+      dest[hist.outflow_size()] = hist.n_entries();
+    }
+    _header->nevents = nevents;
+
+    _header->sequence.store(seq+2, std::memory_order_release);
+  }
+
+  /// unmap and remove the segment (readers that are still attached
+  /// keep their view of the last published state)
+  void close() {
+    if (!active()) return;
+    munmap(_header, _size);
+    shm_unlink(_segment_name.c_str());
+    _header = 0;
+  }
+
+private:
+  std::vector<std::string>        _names;
+  std::vector<const SimpleHist *> _hists;
+  std::vector<uint64_t>           _offsets;
+  std::string                     _segment_name;
+  SharedHistHeader *              _header;
+  double *                        _data;
+  std::size_t                     _size;
+};
+
+
+//----------------------------------------------------------------------
+/// Class that attaches to a segment created by a SharedHistWriter
+/// and returns consistent snapshots of its histograms.
+class SharedHistReader {
+public:
+  SharedHistReader() : _header(0), _size(0) {}
+  ~SharedHistReader() {if (_header) munmap(_header, _size);}
+
+  /// attach (read-only) to the segment; returns false if it does not
+  /// exist, was not created by a compatible SharedHistWriter, or its
+  /// layouts do not fit inside it.
+  bool attach(const std::string & segment_name) {
+    int fd = shm_open(segment_name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(SharedHistHeader)) {
+      ::close(fd); return false;
+    }
+    _size = st.st_size;
+    void * addr = mmap(0, _size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+    _header = static_cast<SharedHistHeader *>(addr);
+    if (std::memcmp(_header->magic, "SIMPHIST", 8) != 0
+        || _header->version != shared_hist_version
+        || _header->total_size != _size
+        || !_layout_fits()) {
+      munmap(addr, _size); _header = 0;
+      return false;
+    }
+    return true;
+  }
+
+  /// fill names and hists with a consistent copy of the segment's
+  /// contents, and nevents with the number of events at which it was
+  /// published. Note that the n_entries() of the copies is not set
+  /// (it is returned separately in n_entries).
+  ///
+  /// Returns false if no consistent copy could be obtained within
+  /// timeout seconds, e.g. because the writer died while publishing.
+  bool snapshot(std::vector<std::string> & names,
+                std::vector<SimpleHist> & hists,
+                std::vector<double> & n_entries,
+                uint64_t & nevents,
+                double timeout = 1.0) const {
+    assert(_header != 0);
+    const SharedHistLayout * layouts =
+      reinterpret_cast<const SharedHistLayout *>(_header + 1);
+    const double * data = reinterpret_cast<const double *>(
+             reinterpret_cast<const char *>(_header) + _header->data_offset);
+    unsigned nhist = _header->nhist;
+    names.resize(nhist);
+    hists.resize(nhist);
+    n_entries.resize(nhist);
+    // the layouts never change after creation
+    for (unsigned ih = 0; ih < nhist; ih++) {
+      names[ih] = std::string(layouts[ih].name,
+                              strnlen(layouts[ih].name, sizeof(layouts[ih].name)));
+      hists[ih].declare(layouts[ih].minv, layouts[ih].maxv, layouts[ih].nbins);
+    }
+
+    const unsigned wait_us = 100;
+    const unsigned max_tries = unsigned(timeout * 1e6 / wait_us) + 1;
+    for (unsigned itry = 0; itry < max_tries; itry++) {
+      if (itry > 0) usleep(wait_us);
+      uint64_t seq_before = _header->sequence.load(std::memory_order_acquire);
+      if (seq_before % 2 != 0) continue;
+      for (unsigned ih = 0; ih < nhist; ih++) {
+        const double * src = data + layouts[ih].offset;
+        for (unsigned i = 0; i < hists[ih].outflow_size(); i++) hists[ih].set(i, src[i]);
+        n_entries[ih] = src[hists[ih].outflow_size()];
+      }
+      nevents = _header->nevents;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_header->sequence.load(std::memory_order_relaxed) == seq_before) return true;
+    }
+    return false;
+  }
+
+private:
+  /// true if the layouts and the data that they point to lie within
+  /// the segment (the layouts never change after creation, so this
+  /// only needs to be checked once)
+  bool _layout_fits() const {
+    std::size_t max_nhist = (_size - sizeof(SharedHistHeader)) / sizeof(SharedHistLayout);
+    if (_header->nhist > max_nhist) return false;
+    uint64_t layouts_end = sizeof(SharedHistHeader) + _header->nhist * sizeof(SharedHistLayout);
+    if (_header->data_offset < layouts_end || _header->data_offset > _size
+        || _header->data_offset % sizeof(double) != 0) return false;
+    uint64_t ndata = (_size - _header->data_offset) / sizeof(double);
+    const SharedHistLayout * layouts =
+      reinterpret_cast<const SharedHistLayout *>(_header + 1);
+    for (unsigned ih = 0; ih < _header->nhist; ih++) {
+      // bins + outflow + n_entries
+      uint64_t nvalues = uint64_t(layouts[ih].nbins) + 2;
+      if (layouts[ih].nbins == 0 || layouts[ih].offset > ndata
+          || nvalues > ndata - layouts[ih].offset) return false;
+    }
+    return true;
+  }
+
+  SharedHistHeader * _header;
+  std::size_t        _size;
+};
+
+#endif // __SHAREDHIST_HH__
@@ -0,0 +1,339 @@
+#ifndef __SIMPLEHIST2D_HH__
+#define __SIMPLEHIST2D_HH__
+
+//----------------------------------------------------------------------
+/// \file SimpleHist2D.hh
+///
+/// A two-dimensional counterpart of SimpleHist, e.g. for the jet mass
+/// v. jet pt
+///
+/// \code
+///   SimpleHist2D mass_v_pt(0.0, 150.0, 2.0,    // x axis: mass
+///                          500.0, 1500.0, 50.0); // y axis: pt
+///   mass_v_pt.add_entry(jet.m(), jet.pt());
+/// \endcode
+///
+/// The bins are stored contiguously in a single valarray, in
+/// row-major order (x is the row index, y the column), with one extra
+/// (outflow) row and one extra outflow column, so that an entry that
+/// is outside the range on either axis still has a well-defined
+/// location and the projections onto each axis remain complete.
+///
+/// The output format is one line per (x,y) bin,
+///
+///   xlo xmid xhi ylo ymid yhi value
+///
+/// with a blank line after each row, as expected by gnuplot's splot.
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<valarray>
+#include<cmath>
+#include<iostream>
+#include<cassert>
+#include<cstddef>
+#include<algorithm>
+
+class SimpleHist2D {
+public:
+  SimpleHist2D() {};
+
+  SimpleHist2D(double xmin, double xmax, double xbin_size,
+               double ymin, double ymax, double ybin_size) {
+    declare(xmin, xmax, xbin_size, ymin, ymax, ybin_size);
+  }
+
+  SimpleHist2D(double xmin, double xmax, int nx,
+               double ymin, double ymax, int ny) {
+    declare(xmin, xmax, nx, ymin, ymax, ny);
+  }
+
+  SimpleHist2D(double xmin, double xmax, unsigned int nx,
+               double ymin, double ymax, unsigned int ny) {
+    declare(xmin, xmax, nx, ymin, ymax, ny);
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double xmin, double xmax, double xbin_size,
+               double ymin, double ymax, double ybin_size) {
+    declare(xmin, xmax, unsigned(0.5+(xmax-xmin)/xbin_size),
+            ymin, ymax, unsigned(0.5+(ymax-ymin)/ybin_size));
+  }
+
+  void declare(double xmin, double xmax, int nx,
+               double ymin, double ymax, int ny) {
+    declare(xmin, xmax, unsigned(nx), ymin, ymax, unsigned(ny));
+  }
+
+  // declare (or redeclare) the histogram
+  void declare(double xmin, double xmax, unsigned int nx,
+               double ymin, double ymax, unsigned int ny) {
+    _xmin = xmin; _xmax = xmax; _nx = nx; _dx = (xmax-xmin)/nx;
+    _ymin = ymin; _ymax = ymax; _ny = ny; _dy = (ymax-ymin)/ny;
+    _inv_dx = 1.0/_dx; _inv_dy = 1.0/_dy;
+    _weights.resize((nx+1)*(ny+1));
+    reset();
+  }
+
+  /// reset the contents of the histogram to zero (does not
+  /// modify the histogram bounds)
+  void reset() {
+    _weights = 0.0;
+    _weight_x = 0.0; _weight_xsq = 0.0;
+    _weight_y = 0.0; _weight_ysq = 0.0;
+    _weight_xy = 0.0;
+    _n_entries = 0.0;
+  }
+
+  double xmin() const {return _xmin;};
+  double xmax() const {return _xmax;};
+  double ymin() const {return _ymin;};
+  double ymax() const {return _ymax;};
+  /// number of bins in x and y, excluding the outflow bins
+  unsigned int xsize() const {return _nx;}
+  unsigned int ysize() const {return _ny;}
+  /// total number of stored bins, including the outflow row and column
+  unsigned int outflow_size() const {return _weights.size();}
+
+  /// access to bin (ix,iy); ix = xsize() or iy = ysize() correspond
+  /// to the outflow
+  double & operator()(unsigned ix, unsigned iy) {return _weights[index(ix,iy)];}
+  const double & operator()(unsigned ix, unsigned iy) const {return _weights[index(ix,iy)];}
+
+  /// access by the flat (row-major) index
+  double & operator[](int i) {return _weights[i];};
+  const double & operator[](int i) const {return _weights[i];};
+
+  /// the flat index for bin (ix,iy)
+  unsigned int index(unsigned ix, unsigned iy) const {return ix*(_ny+1) + iy;}
+
+  double xbinlo (int i) const {return i*_dx + _xmin;};
+  double xbinhi (int i) const {return (i+1)*_dx + _xmin;};
+  double xbinmid(int i) const {return (i+0.5)*_dx + _xmin;};
+  double xbinsize()     const {return _dx;};
+  double ybinlo (int i) const {return i*_dy + _ymin;};
+  double ybinhi (int i) const {return (i+1)*_dy + _ymin;};
+  double ybinmid(int i) const {return (i+0.5)*_dy + _ymin;};
+  double ybinsize()     const {return _dy;};
+
+  /// x bin for the value x (xsize() if it is outside the range)
+  unsigned int xbin(double x) const {
+    if (x >= _xmin && x < _xmax) {
+      unsigned i = unsigned((x-_xmin)*_inv_dx);
+      if (i < _nx) return i;
+    }
+    return _nx;
+  }
+  /// y bin for the value y (ysize() if it is outside the range)
+  unsigned int ybin(double y) const {
+    if (y >= _ymin && y < _ymax) {
+      unsigned i = unsigned((y-_ymin)*_inv_dy);
+      if (i < _ny) return i;
+    }
+    return _ny;
+  }
+  /// flat index of the bin for the point (x,y)
+  unsigned int bin(double x, double y) const {return index(xbin(x), ybin(y));}
+
+  double n_entries() const {return _n_entries;}
+  /// the total weight, including outflow
+  double total_weight() const {return _weights.sum();}
+  double xmean() const {return _weight_x / total_weight();}
+  double ymean() const {return _weight_y / total_weight();}
+
+  /// the (weighted) correlation coefficient of x and y for all
+  /// entries, including those outside the histogram edges
+  double correlation() const {
+    double w = total_weight();
+    double covxy = _weight_xy/w - xmean()*ymean();
+    double varx  = _weight_xsq/w - xmean()*xmean();
+    double vary  = _weight_ysq/w - ymean()*ymean();
+    return covxy / std::sqrt(varx*vary);
+  }
+
+  void add_entry(double x, double y, double weight = 1.0) {
+    _weights[bin(x,y)] += weight;
+    _weight_x   += weight * x;
+    _weight_xsq += weight * x * x;
+    _weight_y   += weight * y;
+    _weight_ysq += weight * y * y;
+    _weight_xy  += weight * x * y;
+    _n_entries  += 1.0;
+  }
+
+  /// add n entries at once, with points (x[i],y[i]) and weights w[i]
+  /// (or unit weights if w is null). The bin indices are computed in
+  /// a first pass and the bins filled in a second, so that the
+  /// first pass is free of dependencies through memory.
+  void add_entries(const double * x, const double * y, std::size_t n,
+                   const double * w = 0) {
+    const std::size_t block = 256;
+    unsigned indices[block];
+    for (std::size_t start = 0; start < n; start += block) {
+      std::size_t nb = std::min(block, n - start);
+      const double * xb = x + start;
+      const double * yb = y + start;
+      for (std::size_t i = 0; i < nb; i++) indices[i] = bin(xb[i], yb[i]);
+      double sx = 0, sxx = 0, sy = 0, syy = 0, sxy = 0;
+      if (w) {
+        const double * wb = w + start;
+        for (std::size_t i = 0; i < nb; i++) {
+          _weights[indices[i]] += wb[i];
+          sx += wb[i]*xb[i]; sxx += wb[i]*xb[i]*xb[i];
+          sy += wb[i]*yb[i]; syy += wb[i]*yb[i]*yb[i];
+          sxy += wb[i]*xb[i]*yb[i];
+        }
+      } else {
+        for (std::size_t i = 0; i < nb; i++) {
+          _weights[indices[i]] += 1.0;
+          sx += xb[i]; sxx += xb[i]*xb[i];
+          sy += yb[i]; syy += yb[i]*yb[i];
+          sxy += xb[i]*yb[i];
+        }
+      }
+      _weight_x += sx; _weight_xsq += sxx;
+      _weight_y += sy; _weight_ysq += syy;
+      _weight_xy += sxy;
+    }
+    _n_entries += n;
+  }
+
+  /// the projection onto the x axis (summing over all y, including
+  /// the y outflow); the x outflow goes into the 1D outflow bin. The
+  /// projection carries the x moments and the number of entries, so
+  /// that its mean() and n_entries() are those of all the entries.
+  SimpleHist x_projection() const {
+    SimpleHist result(_xmin, _xmax, _nx);
+    for (unsigned ix = 0; ix <= _nx; ix++) {
+      double sum = 0;
+      for (unsigned iy = 0; iy <= _ny; iy++) sum += (*this)(ix,iy);
+      result.set(ix, sum);
+    }
+    result.set_moments(_weight_x, _weight_xsq, total_weight(), _n_entries);
+    return result;
+  }
+
+  /// the projection onto the y axis (summing over all x, including
+  /// the x outflow); the y outflow goes into the 1D outflow bin. The
+  /// projection carries the y moments and the number of entries.
+  SimpleHist y_projection() const {
+    SimpleHist result(_ymin, _ymax, _ny);
+    for (unsigned ix = 0; ix <= _nx; ix++) {
+      for (unsigned iy = 0; iy <= _ny; iy++) result.add(iy, (*this)(ix,iy));
+    }
+    result.set_moments(_weight_y, _weight_ysq, total_weight(), _n_entries);
+    return result;
+  }
+
+  // Operations with constants ---------------------------------------
+  SimpleHist2D & operator*=(double fact) {
+    _weights *= fact;
+    _weight_x *= fact; _weight_xsq *= fact;
+    _weight_y *= fact; _weight_ysq *= fact;
+    _weight_xy *= fact;
+    return *this;
+  };
+  SimpleHist2D & operator/=(double fact) {
+    *this *= 1.0/fact;
+    return *this;
+  };
+
+  // Operations with another histogram -------------------------------
+  /// true if the other histogram has the same binning
+  bool same_binning(const SimpleHist2D & other) const {
+    return _nx == other._nx && _ny == other._ny
+      && _xmin == other._xmin && _xmax == other._xmax
+      && _ymin == other._ymin && _ymax == other._ymax;
+  }
+
+  /// merge another histogram (e.g. from another job) into this one
+  SimpleHist2D & operator+=(const SimpleHist2D & other) {
+    assert(same_binning(other));
+    _weights += other._weights;
+    _weight_x += other._weight_x; _weight_xsq += other._weight_xsq;
+    _weight_y += other._weight_y; _weight_ysq += other._weight_ysq;
+    _weight_xy += other._weight_xy;
+    _n_entries += other._n_entries;
+    return *this;
+  };
+
+  SimpleHist2D & operator-=(const SimpleHist2D & other) {
+    assert(same_binning(other));
+    _weights -= other._weights;
+    _weight_x -= other._weight_x; _weight_xsq -= other._weight_xsq;
+    _weight_y -= other._weight_y; _weight_ysq -= other._weight_ysq;
+    _weight_xy -= other._weight_xy;
+    _n_entries += other._n_entries;
+    return *this;
+  };
+
+  SimpleHist2D & operator*=(const SimpleHist2D & other) {
+    assert(same_binning(other));
+    _weights *= other._weights;
+    return *this;
+  };
+
+  SimpleHist2D & operator/=(const SimpleHist2D & other) {
+    assert(same_binning(other));
+    _weights /= other._weights;
+    return *this;
+  };
+
+private:
+  double _xmin, _xmax, _dx, _inv_dx;
+  double _ymin, _ymax, _dy, _inv_dy;
+  unsigned int _nx, _ny;
+  std::valarray<double> _weights;
+  double _weight_x, _weight_xsq, _weight_y, _weight_ysq, _weight_xy;
+  double _n_entries;
+};
+
+
+// Binary operations ------------------------------------------------
+inline SimpleHist2D operator*(const SimpleHist2D & hist, double fact) {
+  SimpleHist2D result(hist); result *= fact; return result;
+}
+inline SimpleHist2D operator/(const SimpleHist2D & hist, double fact) {
+  SimpleHist2D result(hist); result /= fact; return result;
+}
+inline SimpleHist2D operator*(double fact, const SimpleHist2D & hist) {
+  return hist*fact;
+}
+inline SimpleHist2D operator+(const SimpleHist2D & hista, const SimpleHist2D & histb) {
+  SimpleHist2D result(hista); result += histb; return result;
+}
+inline SimpleHist2D operator-(const SimpleHist2D & hista, const SimpleHist2D & histb) {
+  SimpleHist2D result(hista); result -= histb; return result;
+}
+inline SimpleHist2D operator*(const SimpleHist2D & hista, const SimpleHist2D & histb) {
+  SimpleHist2D result(hista); result *= histb; return result;
+}
+inline SimpleHist2D operator/(const SimpleHist2D & hista, const SimpleHist2D & histb) {
+  SimpleHist2D result(hista); result /= histb; return result;
+}
+
+/// output the histogram (excluding outflow) in a form suitable for
+/// gnuplot's splot; the output is multiplied by the factor norm.
+inline void output(const SimpleHist2D & hist,
+                   std::ostream * ostr = (&std::cout),
+                   double norm = 1.0) {
+  for (unsigned ix = 0; ix < hist.xsize(); ix++) {
+    for (unsigned iy = 0; iy < hist.ysize(); iy++) {
+      *ostr << hist.xbinlo(ix)  << " "
+            << hist.xbinmid(ix) << " "
+            << hist.xbinhi(ix)  << " "
+            << hist.ybinlo(iy)  << " "
+            << hist.ybinmid(iy) << " "
+            << hist.ybinhi(iy)  << " "
+            << hist(ix,iy)*norm << std::endl;
+    }
+    *ostr << std::endl;
+  }
+}
+
+inline std::ostream & operator<<(std::ostream & ostr, const SimpleHist2D & hist) {
+  output(hist, &ostr);
+  return ostr;
+}
+
+#endif // __SIMPLEHIST2D_HH__
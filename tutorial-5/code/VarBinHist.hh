@@ -0,0 +1,343 @@
+#ifndef __VARBINHIST_HH__
+#define __VARBINHIST_HH__
+
+//----------------------------------------------------------------------
+/// \file VarBinHist.hh
+///
+/// A histogram with variable-width bins, with the same interface and
+/// output format as SimpleHist. It can be declared either with an
+/// arbitrary (increasing) set of bin edges
+///
+/// \code
+///   double edges[] = {0.0, 10.0, 20.0, 40.0, 80.0, 160.0};
+///   VarBinHist jet_mass(vector<double>(edges, edges+6));
+/// \endcode
+///
+/// or with bins that are uniformly spaced in the logarithm of the
+/// value
+///
+/// \code
+///   VarBinHist jet_pt;
+///   jet_pt.declare_log(20.0, 2000.0, 40);
+/// \endcode
+///
+/// In both cases bin(v) takes constant time: for arbitrary edges a
+/// uniform coarse lookup table, with cells no wider than the
+/// narrowest bin, gives the bin to within one step; for logarithmic
+/// bins the bin index follows directly from log(v/minv), corrected by
+/// at most one step so that it is consistent with the stored edges.
+///
+/// A finely-binned SimpleHist can be turned into a VarBinHist at
+/// output time with rebinned(fine, edges), as long as the edges
+/// coincide with edges of the SimpleHist.
+//----------------------------------------------------------------------
+
+#include "SimpleHist.hh"
+#include<valarray>
+#include<vector>
+#include<cmath>
+#include<iostream>
+#include<cassert>
+
+class VarBinHist {
+public:
+  VarBinHist() {};
+
+  /// histogram with the given bin edges (which must be increasing)
+  VarBinHist(const std::vector<double> & edges) {declare(edges);}
+
+  /// declare (or redeclare) the histogram with the given bin edges
+  void declare(const std::vector<double> & edges) {
+    assert(edges.size() >= 2);
+    _edges = edges;
+    _log = false;
+    _minv = edges.front(); _maxv = edges.back();
+
+    // set up the coarse lookup table: each cell is no wider than the
+    // narrowest bin, so that a value in a given cell is either in the
+    // cell's first bin or the one after it. We cap the table size to
+    // avoid pathological memory use with very narrow bins (in which
+    // case a few more steps may occasionally be needed)
+    double min_width = _maxv - _minv;
+    for (unsigned i = 0; i+1 < edges.size(); i++) {
+      assert(edges[i+1] > edges[i]);
+      min_width = std::min(min_width, edges[i+1] - edges[i]);
+    }
+    unsigned ncells = unsigned(std::min((_maxv - _minv)/min_width + 1.0,
+                                        double(max_cells_per_bin*size())));
+    _inv_cell = ncells / (_maxv - _minv);
+    _lookup.resize(ncells+1);
+    unsigned ibin = 0;
+    for (unsigned icell = 0; icell <= ncells; icell++) {
+      double cell_lo = _minv + icell / _inv_cell;
+      while (ibin+1 < size() && _edges[ibin+1] <= cell_lo) ibin++;
+      _lookup[icell] = ibin;
+    }
+
+    _weights.resize(size()+1);
+    reset();
+  }
+
+  /// declare (or redeclare) the histogram with n bins that are
+  /// uniformly spaced in log(v) between minv and maxv (both > 0)
+  void declare_log(double minv, double maxv, unsigned int n) {
+    assert(minv > 0 && maxv > minv && n > 0);
+    _log = true;
+    _minv = minv; _maxv = maxv;
+    _dlog = std::log(maxv/minv)/n;
+    _inv_dlog = 1.0/_dlog;
+    _edges.resize(n+1);
+    for (unsigned i = 0; i <= n; i++) _edges[i] = minv * std::exp(i*_dlog);
+    _edges[n] = maxv;
+    _lookup.clear();
+    _weights.resize(n+1);
+    reset();
+  }
+
+  /// set the contents of this histogram from those of the finer
+  /// histogram fine, each of whose bins must lie within one of our
+  /// bins (or outside our range, in which case it goes into our
+  /// outflow bin, like fine's outflow). The moments and number of
+  /// entries are copied from fine.
+  void fill_from(const SimpleHist & fine) {
+    reset();
+    for (unsigned i = 0; i < fine.size(); i++) {
+      unsigned ib = bin(fine.binmid(i));
+      assert(ib == size() ||
+             (fine.binlo(i) >= _edges[ib] - 1e-6*fine.binsize() &&
+              fine.binhi(i) <= _edges[ib+1] + 1e-6*fine.binsize()));
+      _weights[ib] += fine[i];
+    }
+    _weights[size()] += fine.outflow();
+    _weight_v   = fine.weight_v();
+    _weight_vsq = fine.weight_vsq();
+    _n_entries  = fine.n_entries();
+  }
+
+  /// reset the contents of the histogram to zero (does not
+  /// modify the histogram bounds)
+  void reset() {
+    _weights = 0.0;
+    _weight_v = 0.0;
+    _weight_vsq = 0.0;
+    _n_entries = 0.0;
+  }
+
+  double min() const {return _minv;};
+  double max() const {return _maxv;};
+  /// returns the size of the histogram proper
+  unsigned int size() const {
+    assert(_edges.size() > 1); // help capture uninitialised histogram bugs
+    return _edges.size()-1;
+  }
+  /// returns the size of the histogram plus outflow bin
+  unsigned int outflow_size() const {return _weights.size();};
+  /// true if the bins are uniformly spaced in log(v)
+  bool is_log() const {return _log;}
+  /// returns the vector of bin edges
+  const std::vector<double> & edges() const {return _edges;}
+
+  double & operator[](int i) {return _weights[i];};
+  const double & operator[](int i) const {return _weights[i];};
+
+  /// returns the outflow bin
+  double & outflow() {return _weights[size()];};
+  const double & outflow() const {return _weights[size()];};
+
+  double binlo (int i) const {return _edges[i];};
+  double binhi (int i) const {return _edges[i+1];};
+  double binmid(int i) const {return 0.5*(_edges[i] + _edges[i+1]);};
+  double binsize(int i) const {return _edges[i+1] - _edges[i];};
+
+  unsigned int bin(double v) const {
+    // this also catches NaNs
+    if (!(v >= _minv && v < _maxv)) return size();
+    unsigned i;
+    if (_log) {
+      i = unsigned(std::log(v/_minv) * _inv_dlog);
+      // rounding can put us one bin away from the one given by the edges
+      if (i >= size()) i = size()-1;
+      if      (v <  _edges[i])   i--;
+      else if (v >= _edges[i+1]) i++;
+    } else {
+      unsigned icell = unsigned((v-_minv)*_inv_cell);
+      if (icell >= _lookup.size()) icell = _lookup.size()-1;
+      i = _lookup[icell];
+      while (v >= _edges[i+1]) i++;
+    }
+    return i;
+  }
+
+  /// return the mean value of all events given to histogram
+  /// including those that were outside the histogram edges
+  double mean() const {return _weight_v / total_weight();}
+
+  /// return the total weight in the histogram
+  double total_weight() const {return _weights.sum();}
+
+  double n_entries() const {return _n_entries;}
+
+  void add_entry(double v, double weight = 1.0) {
+    _weights[bin(v)] += weight;
+    _weight_v += weight * v;
+    _weight_vsq += weight * v * v;
+    _n_entries += 1.0;
+  };
+
+  // Operations with constants ---------------------------------------
+  VarBinHist & operator*=(double fact) {
+    _weights *= fact;
+    _weight_v *= fact;
+    _weight_vsq *= fact;
+    return *this;
+  };
+  VarBinHist & operator/=(double fact) {
+    *this *= 1.0/fact;
+    return *this;
+  };
+
+  // Operations with another histogram -------------------------------
+  VarBinHist & operator*=(const VarBinHist & other) {
+    assert(same_binning(other));
+    _weights *= other._weights;
+    return *this;
+  };
+
+  VarBinHist & operator/=(const VarBinHist & other) {
+    assert(same_binning(other));
+    _weights /= other._weights;
+    return *this;
+  };
+
+  VarBinHist & operator+=(const VarBinHist & other) {
+    assert(same_binning(other));
+    _weights += other._weights;
+    _weight_v += other._weight_v;
+    _weight_vsq += other._weight_vsq;
+    _n_entries += other._n_entries;
+    return *this;
+  };
+
+  VarBinHist & operator-=(const VarBinHist & other) {
+    assert(same_binning(other));
+    _weights -= other._weights;
+    _weight_v -= other._weight_v;
+    _weight_vsq -= other._weight_vsq;
+    _n_entries += other._n_entries;
+    return *this;
+  };
+
+  /// divide each bin by its width (e.g. to get a distribution from
+  /// counts, which is usually what one wants with variable bins)
+  void divide_by_binsize() {
+    for (unsigned i = 0; i < size(); i++) _weights[i] /= binsize(i);
+  }
+
+  /// true if the other histogram has the same bin edges
+  bool same_binning(const VarBinHist & other) const {
+    return _edges == other._edges;
+  }
+
+  /// apply f to each bin (including the outflow)
+  VarBinHist & apply(double (*f)(double)) {
+    _weights = _weights.apply(f);
+    return *this;
+  }
+
+private:
+  /// the maximum size of the lookup table, per bin
+  static const unsigned max_cells_per_bin = 64;
+
+  double _minv, _maxv;
+  std::vector<double> _edges;
+  bool   _log;
+  // for log bins
+  double _dlog, _inv_dlog;
+  // for arbitrary bins: _lookup[icell] is the bin containing the
+  // lower edge of cell icell
+  double _inv_cell;
+  std::vector<unsigned> _lookup;
+
+  std::valarray<double> _weights;
+  double _weight_v, _weight_vsq;
+  double _n_entries;
+};
+
+
+/// return the finely-binned histogram fine rebinned into the bins
+/// with the given edges (see VarBinHist::fill_from)
+inline VarBinHist rebinned(const SimpleHist & fine, const std::vector<double> & edges) {
+  VarBinHist result(edges);
+  result.fill_from(fine);
+  return result;
+}
+
+// Binary operations with constants -----------------------------
+inline VarBinHist operator*(const VarBinHist & hist, double fact) {
+  VarBinHist result(hist); result *= fact; return result;
+}
+inline VarBinHist operator/(const VarBinHist & hist, double fact) {
+  VarBinHist result(hist); result /= fact; return result;
+}
+inline VarBinHist operator*(double fact, const VarBinHist & hist) {
+  return hist*fact;
+}
+
+// Binary operations with other histograms ------------------------
+inline VarBinHist operator*(const VarBinHist & hista, const VarBinHist & histb) {
+  VarBinHist result(hista); result *= histb; return result;
+}
+inline VarBinHist operator/(const VarBinHist & hista, const VarBinHist & histb) {
+  VarBinHist result(hista); result /= histb; return result;
+}
+inline VarBinHist operator+(const VarBinHist & hista, const VarBinHist & histb) {
+  VarBinHist result(hista); result += histb; return result;
+}
+inline VarBinHist operator-(const VarBinHist & hista, const VarBinHist & histb) {
+  VarBinHist result(hista); result -= histb; return result;
+}
+
+// Unary mathematical functions
+inline VarBinHist sqrt(const VarBinHist & hist) {
+  VarBinHist result(hist); result.apply(std::sqrt); return result;
+}
+inline VarBinHist pow2(const VarBinHist & hist) {
+  return hist*hist;
+}
+
+/// output the histogram, in the same format as for SimpleHist; the
+/// output is multiplied by the factor norm.
+inline void output(const VarBinHist & hist0,
+                   std::ostream * ostr = (&std::cout),
+                   double norm = 1.0) {
+  for (unsigned i = 0; i < hist0.size(); i++) {
+    *ostr << hist0.binlo(i)  << " "
+          << hist0.binmid(i) << " "
+          << hist0.binhi(i) << " "
+          << hist0[i]*norm << std::endl;
+  }
+}
+
+inline std::ostream & operator<<(std::ostream & ostr, const VarBinHist & hist) {
+  output(hist, &ostr);
+  return ostr;
+}
+
+/// output several histograms with the same binning side by side
+inline void output(const std::vector<VarBinHist> & hists,
+                   std::ostream * ostr = (&std::cout),
+                   double norm = 1.0) {
+  for (unsigned ih = 1; ih < hists.size(); ih++)
+    assert(hists[0].same_binning(hists[ih]));
+
+  for (unsigned i = 0; i < hists[0].size(); i++) {
+    *ostr << hists[0].binlo(i)  << " "
+          << hists[0].binmid(i) << " "
+          << hists[0].binhi(i)  ;
+    for (unsigned ih = 0; ih < hists.size(); ih++)
+      *ostr << " " << hists[ih][i] * norm;
+    *ostr << std::endl;
+  }
+}
+
+#endif // __VARBINHIST_HH__
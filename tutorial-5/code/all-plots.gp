@@ -28,6 +28,31 @@ set xlabel xaxis
 set ylabel 'n_{events} in '.xaxis.' bin'
 plot datafile index 1 u 2:4 w histeps t ''
 
+xaxis='p_{t,jet}'
+set title xaxis
+set xlabel xaxis
+set ylabel 'dn_{events}/d'.xaxis
+set logscale xy
+# bins are uniform in log(pt), so give boxes their actual width
+plot datafile index 2 u 2:4:($3-$1) w boxes t ''
+unset logscale
+
+# jet mass for each event weight (with -variations on, cols 5 and 6
+# are the shower renormalisation scale variations)
+xaxis='m_{jet}'
+set title xaxis.' (weight variations)'
+set xlabel xaxis
+set ylabel 'n_{events} in '.xaxis.' bin'
+plot 'main01-variations.out' u 2:4 w histeps t 'nominal',\
+     '' u 2:5 w histeps t 'variation 1',\
+     '' u 2:6 w histeps t 'variation 2'
+
+set title 'jet mass v. p_{t,jet}'
+set xlabel 'm_{jet}'
+set ylabel 'p_{t,jet}'
+set view map
+splot 'main01-mass-v-pt.out' u 2:5:7 w pm3d t ''
+
 # put your code here
 
 set output
@@ -8,6 +8,8 @@
 #include "Pythia8/Pythia.h"
 #include "FJCorePythia.hh"
 #include <sstream>
+#include <string>
+#include <vector>
 
 namespace Pythia8 {
 namespace fjcore {
@@ -25,6 +27,20 @@ inline ostream & operator<<(ostream & ostr, PseudoJet & p) {
 }
 
 
+/// fill ids, flavours and (if non-null) charges with the PDG id, net
+/// flavour content and charge of each particle in the event (in the
+/// event's order), decoding all the ids in one go
+inline void decode_event_flavours(const Pythia8::Event & event,
+                                  std::vector<int> & ids,
+                                  std::vector<PackedFlavour> & flavours,
+                                  std::vector<double> * charges = 0) {
+  unsigned n = event.size();
+  ids.resize(n); flavours.resize(n);
+  if (charges) charges->resize(n);
+  for (unsigned i = 0; i < n; i++) ids[i] = event[i].id();
+  if (n > 0) decode_pdg_ids(&ids[0], n, &flavours[0], charges ? &(*charges)[0] : 0);
+}
+
 /// make particle flavour id stable
 inline void set_stable(Pythia8::Pythia & pythia, unsigned int id) {
   std::ostringstream oss;
@@ -32,6 +48,84 @@ inline void set_stable(Pythia8::Pythia & pythia, unsigned int id) {
   pythia.readString(oss.str());
 }
 
+//----------------------------------------------------------------------
+/// Class that holds a set of particle-data settings, e.g. to make a
+/// class of particles stable, built once (with a single scan of the
+/// particle data for a predicate) and then applied to any number of
+/// Pythia instances, e.g.
+///
+/// \code
+///   ParticleSettings settings;
+///   settings.set_may_decay(pythia.particleData, HasFlavour(5), false);
+///   settings.apply(pythia);                       // or, as a settings fragment,
+///   cout << settings.fragment();                  // "511:mayDecay = off" etc.
+/// \endcode
+///
+/// apply() sets mayDecay directly in the particle data, without going
+/// through the parsing of readString.
+class ParticleSettings {
+public:
+  /// set mayDecay for the particle id
+  void set_may_decay(int id, bool may_decay) {
+    Entry entry = {id, may_decay};
+    _entries.push_back(entry);
+  }
+
+  /// set mayDecay for every particle in the particle data for which
+  /// pred(id) is true (antiparticles share their particle's entry);
+  /// returns the number of particles that were matched
+  template<class Pred>
+  unsigned set_may_decay(Pythia8::ParticleData & particle_data, Pred pred, bool may_decay) {
+    unsigned n = 0;
+    for (int id = particle_data.nextId(0); id != 0; id = particle_data.nextId(id)) {
+      if (pred(id)) {set_may_decay(id, may_decay); n++;}
+    }
+    return n;
+  }
+
+  /// apply the settings to pythia (before pythia.init())
+  void apply(Pythia8::Pythia & pythia) const {
+    for (unsigned i = 0; i < _entries.size(); i++) {
+      pythia.particleData.mayDecay(_entries[i].id, _entries[i].may_decay);
+    }
+  }
+
+  /// return the settings as a fragment of Pythia settings, one per
+  /// line, suitable for readString, or readFile in other jobs
+  std::string fragment() const {
+    std::ostringstream oss;
+    for (unsigned i = 0; i < _entries.size(); i++) {
+      oss << _entries[i].id << ":mayDecay = " << (_entries[i].may_decay ? "on" : "off") << std::endl;
+    }
+    return oss.str();
+  }
+
+  /// return the number of settings
+  unsigned size() const {return _entries.size();}
+
+private:
+  struct Entry {int id; bool may_decay;};
+  std::vector<Entry> _entries;
+};
+
+/// predicate that is true for particles with non-zero net content of
+/// the quark flavour iflv (d=1, u=2, s=3, c=4, b=5, t=6), according
+/// to FlavourHolder
+class HasFlavour {
+public:
+  HasFlavour(int iflv) : _iflv(iflv) {}
+  bool operator()(int id) const {
+    int content[7] = {0,0,0,0,0,0,0};
+    return FlavourHolder::decode(id, content) && content[_iflv] != 0;
+  }
+private:
+  int _iflv;
+};
+
+/// return the settings that make b quarks and all long-lived
+/// B-hadrons stable (built once and then cached)
+const ParticleSettings & bflavour_stable_settings();
+
 /// make all long-lived B-hadrons stable
 void set_bflavour_stable(Pythia8::Pythia & pythia);
 #endif //  __HELPERS_HH__
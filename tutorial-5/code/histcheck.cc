@@ -0,0 +1,208 @@
+// histcheck.cc: checks of the histogram classes that do not need
+// Pythia or fjcore, e.g. that bin lookups agree with a direct search
+// through the bin edges. Run with
+//
+//   make check
+//
+// which prints each failed check and exits with a non-zero code if
+// there were any.
+
+#include "VarBinHist.hh"
+#include "SimpleHist2D.hh"
+#include "MultiWeightHist.hh"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+
+/// the number of failed checks
+int nfailed = 0;
+
+/// record a failed check if ok is false
+void check(bool ok, const string & what) {
+  if (!ok) {
+    cerr << "histcheck: FAILED: " << what << endl;
+    nfailed++;
+  }
+}
+
+/// the bin containing v, found by a direct search through the edges
+unsigned direct_bin(const VarBinHist & hist, double v) {
+  const vector<double> & edges = hist.edges();
+  if (!(v >= edges.front() && v < edges.back())) return hist.size();
+  unsigned i = 0;
+  while (v >= edges[i+1]) i++;
+  return i;
+}
+
+/// check hist.bin() against direct_bin() exactly at each edge, just
+/// below it and at a set of pseudo-random values spanning the range
+/// (and a bit beyond it)
+void check_lookup(const VarBinHist & hist, const string & name) {
+  const vector<double> & edges = hist.edges();
+  double lo = edges.front(), hi = edges.back();
+  vector<double> values;
+  for (unsigned i = 0; i < edges.size(); i++) {
+    values.push_back(edges[i]);
+    values.push_back(nextafter(edges[i], -numeric_limits<double>::infinity()));
+    values.push_back(nextafter(edges[i],  numeric_limits<double>::infinity()));
+  }
+  srand(1);
+  for (unsigned i = 0; i < 100000; i++) {
+    values.push_back(lo - 0.1*(hi-lo) + 1.2*(hi-lo)*rand()/double(RAND_MAX));
+  }
+  values.push_back(numeric_limits<double>::quiet_NaN());
+
+  unsigned nbad = 0;
+  for (unsigned i = 0; i < values.size(); i++) {
+    if (hist.bin(values[i]) != direct_bin(hist, values[i])) {
+      if (nbad == 0) cerr << "histcheck: " << name << ": bin(" << values[i] << ") = "
+                          << hist.bin(values[i]) << ", expected "
+                          << direct_bin(hist, values[i]) << endl;
+      nbad++;
+    }
+  }
+  check(nbad == 0, name + ": bin lookup agrees with the edges");
+  for (unsigned i = 0; i+1 < edges.size(); i++) {
+    check(hist.bin(edges[i]) == i, name + ": lower bin edges are inside their bin");
+  }
+  check(hist.bin(hi) == hist.size(), name + ": upper edge goes to the outflow");
+}
+
+void check_varbinhist() {
+  // arbitrary edges, including a very narrow bin
+  double edges[] = {0.0, 10.0, 20.0, 20.001, 40.0, 80.0, 160.0};
+  VarBinHist var(vector<double>(edges, edges+7));
+  check_lookup(var, "VarBinHist(edges)");
+
+  // logarithmic bins, where rounding in the log can be one bin off
+  VarBinHist log_bins;
+  log_bins.declare_log(20.0, 2000.0, 40);
+  check_lookup(log_bins, "VarBinHist::declare_log");
+  log_bins.declare_log(1e-3, 7.0, 13);
+  check_lookup(log_bins, "VarBinHist::declare_log (odd range)");
+
+  // subtracting a histogram removes its moments as well as its weights
+  VarBinHist a(vector<double>(edges, edges+7)), b(a);
+  for (unsigned i = 0; i < 100; i++) a.add_entry(1.6*i, 1.0);
+  for (unsigned i = 0; i < 50;  i++) b.add_entry(3.1*i, 2.0);
+  VarBinHist diff = (a + b) - b;
+  check(std::abs(diff.mean() - a.mean()) < 1e-9 * std::abs(a.mean()),
+        "VarBinHist: (a+b)-b has the mean of a");
+  check(std::abs(diff.total_weight() - a.total_weight()) < 1e-9,
+        "VarBinHist: (a+b)-b has the total weight of a");
+}
+
+void check_simplehist2d() {
+  SimpleHist2D hist(0.0, 10.0, 5, -1.0, 1.0, 4);
+  unsigned nx = hist.xsize(), ny = hist.ysize();
+
+  // row-major storage, with the outflow row and column
+  check(hist.outflow_size() == (nx+1)*(ny+1), "SimpleHist2D: storage size");
+  check(hist.index(1,2) == 1*(ny+1) + 2, "SimpleHist2D: row-major index");
+  check(hist.bin(2.5, 0.1) == hist.index(1,2), "SimpleHist2D: bin of an in-range point");
+
+  // points outside the range on either or both axes
+  hist.add_entry(11.0,  0.1);   // x outflow
+  hist.add_entry( 2.5,  5.0);   // y outflow
+  hist.add_entry(-1.0, -5.0);   // both
+  hist.add_entry( 2.5,  0.1);
+  check(hist(nx, 2) == 1.0, "SimpleHist2D: x outflow goes into the outflow row");
+  check(hist(1, ny) == 1.0, "SimpleHist2D: y outflow goes into the outflow column");
+  check(hist(nx, ny) == 1.0, "SimpleHist2D: x and y outflow goes into the corner");
+  check(hist(1, 2) == 1.0, "SimpleHist2D: in-range entry");
+  check(hist.x_projection().outflow() == 2.0, "SimpleHist2D: x projection outflow");
+  check(hist.y_projection().outflow() == 2.0, "SimpleHist2D: y projection outflow");
+  check(hist.x_projection().total_weight() == 4.0, "SimpleHist2D: x projection is complete");
+
+  // a batched fill (over several blocks) gives the same as single fills
+  unsigned n = 1000;
+  vector<double> x(n), y(n), w(n);
+  for (unsigned i = 0; i < n; i++) {
+    x[i] = -1.0 + 12.0*i/n; y[i] = std::sin(0.37*i) * 1.2; w[i] = 0.5 + (i%7);
+  }
+  for (unsigned weighted = 0; weighted < 2; weighted++) {
+    SimpleHist2D single(0.0, 10.0, 5, -1.0, 1.0, 4), batched(single);
+    for (unsigned i = 0; i < n; i++) single.add_entry(x[i], y[i], weighted ? w[i] : 1.0);
+    batched.add_entries(&x[0], &y[0], n, weighted ? &w[0] : 0);
+    bool same = true;
+    for (unsigned i = 0; i < single.outflow_size(); i++) same = same && (single[i] == batched[i]);
+    string name = weighted ? "weighted" : "unweighted";
+    check(same, "SimpleHist2D: " + name + " batched fill gives the same bins");
+    check(std::abs(single.correlation() - batched.correlation()) < 1e-9
+          && single.n_entries() == batched.n_entries(),
+          "SimpleHist2D: " + name + " batched fill gives the same moments");
+  }
+
+  // subtracting a histogram removes its moments as well as its weights
+  SimpleHist2D a(0.0, 10.0, 5, -1.0, 1.0, 4), b(a);
+  a.add_entries(&x[0], &y[0], n);
+  b.add_entries(&x[0], &y[0], n/2, &w[0]);
+  SimpleHist2D diff = (a + b) - b;
+  check(std::abs(diff.xmean() - a.xmean()) < 1e-9 * std::abs(a.xmean())
+        && std::abs(diff.correlation() - a.correlation()) < 1e-9,
+        "SimpleHist2D: (a+b)-b has the moments of a");
+}
+
+/// true if a and b have the same bins (including the outflow)
+bool same_bins(const SimpleHist & a, const SimpleHist & b) {
+  if (a.outflow_size() != b.outflow_size()) return false;
+  for (unsigned i = 0; i < a.outflow_size(); i++) {
+    if (std::abs(a[i] - b[i]) > 1e-12 * (std::abs(a[i]) + std::abs(b[i]))) return false;
+  }
+  return true;
+}
+
+void check_multiweighthist() {
+  // an int bin count, as for SimpleHist
+  const unsigned nweights = 3;
+  MultiWeightHist single(0.0, 10.0, 10, nweights);
+  check(single.size() == 10 && single.binsize() == 1.0, "MultiWeightHist: int bin count");
+  MultiWeightHist batched(single), same_weights(single);
+
+  // each variation extracted with variation(iw) should be the same
+  // as a SimpleHist filled with that weight alone
+  vector<SimpleHist> reference(nweights, SimpleHist(0.0, 10.0, 10));
+  unsigned n = 600;
+  vector<double> v(n), w(n*nweights);
+  for (unsigned i = 0; i < n; i++) {
+    v[i] = -0.5 + 11.0*i/n;
+    for (unsigned iw = 0; iw < nweights; iw++) w[i*nweights+iw] = 1.0 + 0.1*iw + 0.01*(i%5);
+  }
+  for (unsigned i = 0; i < n; i++) {
+    single.add_entry(v[i], &w[i*nweights]);
+    for (unsigned iw = 0; iw < nweights; iw++) reference[iw].add_entry(v[i], w[i*nweights+iw]);
+  }
+  batched.add_entries(&v[0], n, &w[0]);
+  for (unsigned iw = 0; iw < nweights; iw++) {
+    check(same_bins(single.variation(iw), reference[iw]), "MultiWeightHist: single fill, variation bins");
+    check(same_bins(batched.variation(iw), reference[iw]), "MultiWeightHist: batched fill, variation bins");
+    check(std::abs(batched.variation(iw).mean() - reference[iw].mean()) < 1e-9
+          && batched.variation(iw).n_entries() == reference[iw].n_entries(),
+          "MultiWeightHist: variation moments");
+  }
+
+  // several entries with the same weights, e.g. the jets of one event
+  same_weights.add_entries_same_weights(&v[0], n, &w[0]);
+  SimpleHist reference_same(0.0, 10.0, 10);
+  for (unsigned i = 0; i < n; i++) reference_same.add_entry(v[i], w[nweights-1]);
+  check(same_bins(same_weights.variation(nweights-1), reference_same)
+        && std::abs(same_weights.variation(nweights-1).mean() - reference_same.mean()) < 1e-9,
+        "MultiWeightHist: add_entries_same_weights");
+}
+
+int main() {
+  check_varbinhist();
+  check_simplehist2d();
+  check_multiweighthist();
+
+  if (nfailed > 0) {
+    cerr << "histcheck: " << nfailed << " check(s) failed" << endl;
+    return -1;
+  }
+  cout << "histcheck: all checks passed" << endl;
+  return 0;
+}
@@ -0,0 +1,197 @@
+// histmerge.cc: merge (sum) and optionally rebin histogram output
+// files in the format written by main01 (and histmon), e.g. from
+// several jobs run with different seeds.
+//
+// Usage:
+//
+//   ./histmerge [-rebin N | -edges 0,10,20,40,80] [-out file] file1 [file2 ...]
+//
+// Each file consists of blocks of lines "binlo binmid binhi value",
+// separated by blank lines and preceded by "# ..." comment lines. The
+// values of corresponding blocks are summed across files, and the
+// comments are taken from the first file. With -rebin N each group of
+// N consecutive bins is merged into one (left-over bins at the top of
+// a block are dropped); with -edges the bins are merged into the
+// given, possibly variable, bins, whose edges must coincide with bin
+// edges in the input (input bins outside the edges are dropped).
+//
+// The text output does not contain the outflow bins or the moments,
+// so they cannot be recovered here; to keep them, rebin the
+// histograms in the job itself with SimpleHist::rebinned(...) or
+// rebinned(SimpleHist, edges) from VarBinHist.hh.
+
+#include "CmdLine.hh"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+
+/// one row of a histogram block
+struct HistRow {
+  double lo, mid, hi, value;
+};
+
+/// a block of rows, with the comment lines that precede it
+struct HistBlock {
+  vector<string>  comments;
+  vector<HistRow> rows;
+};
+
+/// read the blocks from the named file
+vector<HistBlock> read_blocks(const string & filename) {
+  ifstream file(filename.c_str());
+  if (!file.good()) {
+    cerr << "histmerge: could not open " << filename << endl;
+    exit(-1);
+  }
+  vector<HistBlock> blocks;
+  HistBlock current;
+  string line;
+  while (getline(file, line)) {
+    if (line.size() > 0 && line[0] == '#') {
+      // a comment after some rows starts a new block
+      if (current.rows.size() > 0) {blocks.push_back(current); current = HistBlock();}
+      current.comments.push_back(line);
+    } else if (line.find_first_not_of(" \t") == string::npos) {
+      if (current.rows.size() > 0) {blocks.push_back(current); current = HistBlock();}
+    } else {
+      istringstream istr(line);
+      HistRow row;
+      if (!(istr >> row.lo >> row.mid >> row.hi >> row.value)) {
+        cerr << "histmerge: could not parse line in " << filename << ": " << line << endl;
+        exit(-1);
+      }
+      current.rows.push_back(row);
+    }
+  }
+  if (current.rows.size() > 0) blocks.push_back(current);
+  return blocks;
+}
+
+/// return the block with groups of factor consecutive bins merged
+HistBlock rebin(const HistBlock & block, unsigned factor) {
+  HistBlock result;
+  result.comments = block.comments;
+  for (unsigned i = 0; i + factor <= block.rows.size(); i += factor) {
+    HistRow row;
+    row.lo  = block.rows[i].lo;
+    row.hi  = block.rows[i+factor-1].hi;
+    row.mid = 0.5*(row.lo + row.hi);
+    row.value = 0.0;
+    for (unsigned j = i; j < i + factor; j++) row.value += block.rows[j].value;
+    result.rows.push_back(row);
+  }
+  return result;
+}
+
+/// return the block with its bins merged into the bins with the given
+/// edges
+HistBlock rebin(const HistBlock & block, const vector<double> & edges) {
+  HistBlock result;
+  result.comments = block.comments;
+  for (unsigned ib = 0; ib+1 < edges.size(); ib++) {
+    HistRow row;
+    row.lo = edges[ib]; row.hi = edges[ib+1];
+    row.mid = 0.5*(row.lo + row.hi);
+    row.value = 0.0;
+    result.rows.push_back(row);
+  }
+  for (unsigned i = 0; i < block.rows.size(); i++) {
+    const HistRow & fine = block.rows[i];
+    double tolerance = 1e-6 * (fine.hi - fine.lo);
+    for (unsigned ib = 0; ib < result.rows.size(); ib++) {
+      HistRow & coarse = result.rows[ib];
+      if (fine.mid < coarse.lo || fine.mid >= coarse.hi) continue;
+      if (fine.lo < coarse.lo - tolerance || fine.hi > coarse.hi + tolerance) {
+        cerr << "histmerge: input bin " << fine.lo << " - " << fine.hi
+             << " straddles the edges " << coarse.lo << " - " << coarse.hi << endl;
+        exit(-1);
+      }
+      coarse.value += fine.value;
+      break;
+    }
+  }
+  return result;
+}
+
+int main(int argc, char ** argv) {
+  CmdLine cmdline(argc,argv);
+  unsigned factor  = cmdline.value("-rebin", 1);
+  string edges_str = cmdline.value<string>("-edges", "");
+  string out_name  = cmdline.value<string>("-out", "");
+  cmdline.assert_all_options_used();
+
+  // the input files are the arguments that are neither options nor
+  // the values of options (all of which take a value)
+  const vector<string> & args = cmdline.arguments();
+  vector<string> filenames;
+  for (unsigned iarg = 1; iarg < args.size(); iarg++) {
+    if (args[iarg].compare(0,1,"-") == 0) {iarg++; continue;}
+    filenames.push_back(args[iarg]);
+  }
+  if (filenames.size() == 0) {
+    cerr << "histmerge: no input files" << endl;
+    return -1;
+  }
+
+  vector<double> edges;
+  if (edges_str != "") {
+    istringstream istr(edges_str);
+    string edge;
+    while (getline(istr, edge, ',')) edges.push_back(atof(edge.c_str()));
+    for (unsigned i = 1; i < edges.size(); i++) assert(edges[i] > edges[i-1]);
+    assert(edges.size() >= 2);
+  }
+
+  // sum the blocks across files
+  vector<HistBlock> blocks = read_blocks(filenames[0]);
+  for (unsigned ifile = 1; ifile < filenames.size(); ifile++) {
+    vector<HistBlock> other = read_blocks(filenames[ifile]);
+    if (other.size() != blocks.size()) {
+      cerr << "histmerge: " << filenames[ifile] << " has a different number of histograms from "
+           << filenames[0] << endl;
+      return -1;
+    }
+    for (unsigned ib = 0; ib < blocks.size(); ib++) {
+      if (other[ib].rows.size() != blocks[ib].rows.size()) {
+        cerr << "histmerge: histogram " << ib << " in " << filenames[ifile]
+             << " has a different binning from that in " << filenames[0] << endl;
+        return -1;
+      }
+      for (unsigned i = 0; i < blocks[ib].rows.size(); i++) {
+        HistRow & row = blocks[ib].rows[i];
+        const HistRow & other_row = other[ib].rows[i];
+        double tolerance = 1e-6 * std::abs(row.hi - row.lo);
+        if (std::abs(other_row.lo - row.lo) > tolerance || std::abs(other_row.hi - row.hi) > tolerance) {
+          cerr << "histmerge: histogram " << ib << " in " << filenames[ifile]
+               << " has bin " << other_row.lo << " - " << other_row.hi << " where "
+               << filenames[0] << " has " << row.lo << " - " << row.hi << endl;
+          return -1;
+        }
+        row.value += other_row.value;
+      }
+    }
+  }
+
+  ofstream file;
+  ostream * ostr = &cout;
+  if (out_name != "") {file.open(out_name.c_str()); ostr = &file;}
+
+  *ostr << "# " << cmdline.command_line() << endl;
+  for (unsigned ib = 0; ib < blocks.size(); ib++) {
+    HistBlock block = blocks[ib];
+    if      (edges.size() > 0) block = rebin(block, edges);
+    else if (factor > 1)       block = rebin(block, factor);
+    for (unsigned i = 0; i < block.comments.size(); i++) *ostr << block.comments[i] << endl;
+    for (unsigned i = 0; i < block.rows.size(); i++) {
+      const HistRow & row = block.rows[i];
+      *ostr << row.lo << " " << row.mid << " " << row.hi << " " << row.value << endl;
+    }
+    *ostr << endl << endl;
+  }
+  return 0;
+}
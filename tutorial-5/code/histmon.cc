@@ -0,0 +1,57 @@
+// histmon.cc: print the current state of the histograms of a running
+// job that was started with the -shm option (see SharedHist.hh).
+//
+// Usage:
+//
+//   ./histmon -shm /main01 [-out file] [-name "jet mass"] [-timeout 1.0]
+//
+// The output has the same format as main01.out, with an additional
+// header line giving the number of events at the last update.
+
+#include "SharedHist.hh"
+#include "SimpleHist.hh"
+#include "CmdLine.hh"
+#include <fstream>
+
+using namespace std;
+
+int main(int argc, char ** argv) {
+  CmdLine cmdline(argc,argv);
+  string shm_name = cmdline.value<string>("-shm");
+  string out_name = cmdline.value<string>("-out", "");
+  // if set, only this histogram is printed
+  string hist_name = cmdline.value<string>("-name", "");
+  // how long (in seconds) to wait for the job to finish an update
+  double timeout = cmdline.value("-timeout", 1.0);
+  cmdline.assert_all_options_used();
+
+  SharedHistReader reader;
+  if (!reader.attach(shm_name)) {
+    cerr << "histmon: could not attach to shared-memory segment " << shm_name
+         << " (it does not exist or does not hold a valid set of histograms)" << endl;
+    return -1;
+  }
+
+  vector<string>     names;
+  vector<SimpleHist> hists;
+  vector<double>     n_entries;
+  uint64_t           nevents;
+  if (!reader.snapshot(names, hists, n_entries, nevents, timeout)) {
+    cerr << "histmon: no consistent copy of " << shm_name << " within " << timeout
+         << " s; the job may have died while publishing its histograms" << endl;
+    return -1;
+  }
+
+  ofstream file;
+  ostream * ostr = &cout;
+  if (out_name != "") {file.open(out_name.c_str()); ostr = &file;}
+
+  *ostr << "# " << cmdline.command_line() << endl;
+  *ostr << "# nevents = " << (unsigned long long)(nevents) << endl;
+  for (unsigned ih = 0; ih < hists.size(); ih++) {
+    if (hist_name != "" && names[ih] != hist_name) continue;
+    *ostr << "# " << names[ih] << " (n_entries = " << n_entries[ih] << ")" << endl;
+    *ostr << hists[ih] << endl << endl;
+  }
+  return 0;
+}
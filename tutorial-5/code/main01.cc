@@ -11,6 +11,11 @@
 #include "Pythia8/FJcore.h"  // subset of FastJet clustering
 #include "helpers.hh"
 #include "SimpleHist.hh"
+#include "VarBinHist.hh"
+#include "SimpleHist2D.hh"
+#include "MultiWeightHist.hh"
+#include "QuantileSketch.hh"
+#include "SharedHist.hh"
 #include "CmdLine.hh"
 // slightly extended version of Pythia8Plugins/FastJet3.h, adapted to fjcore
 // rather than FastJet
@@ -33,8 +38,38 @@ int main(int argc, char ** argv) {
   string ISR   = cmdline.value<string>("-ISR", "on");
   double ptmin = cmdline.value("-ptmin", 500.0);
   double mmin  = cmdline.value("-mmin", 1000.0);
+  // if non-zero, events are generated with a bias (pTHat/ptmin)^bias_pow
+  // towards high pTHat, and come with compensating weights, which
+  // are used for all the histograms
+  double bias_pow = cmdline.value("-bias-pow", 0.0);
+  // if set, publish the histograms to this shared-memory segment
+  // every shm_every events, so that they can be monitored with histmon
+  string shm_name  = cmdline.value<string>("-shm", "");
+  int    shm_every = cmdline.value("-shm-every", 100);
+  // the histograms are filled with fine bins, and each group of
+  // rebin fine bins is merged into one on output
+  int    rebin     = cmdline.value("-rebin", 4);
+  // if on, Pythia also provides event weights for variations of the
+  // shower renormalisation scales, and the jet mass is histogrammed
+  // for each of them
+  string variations = cmdline.value<string>("-variations", "off");
+  // optionally, stop before nEvents once the (output) jet-mass bin
+  // containing target_mass has a relative error below precision;
+  // this is checked every check_every events
+  double target_mass = cmdline.value("-target-mass", -1.0);
+  double precision   = cmdline.value("-precision", 0.01);
+  int    check_every = cmdline.value("-check-every", 1000);
 
   cmdline.assert_all_options_used();
+
+  if (shm_every <= 0) {
+    cerr << "-shm-every must be positive (got " << shm_every << ")" << endl;
+    exit(-1);
+  }
+  if (check_every <= 0) {
+    cerr << "-check-every must be positive (got " << check_every << ")" << endl;
+    exit(-1);
+  }
   
   // Generator. Process selection. LHC initialization. Histogram.
   Pythia pythia;
@@ -50,6 +85,11 @@ int main(int argc, char ** argv) {
   // Tell Pythia to generate only a portion of phasespace
   pythia.settings.parm("PhaseSpace:pTHatMin", ptmin);
   pythia.settings.parm("PhaseSpace:mHatMin", mmin);
+  if (bias_pow != 0.0) {
+    pythia.readString("PhaseSpace:bias2Selection = on");
+    pythia.settings.parm("PhaseSpace:bias2SelectionPow", bias_pow);
+    pythia.settings.parm("PhaseSpace:bias2SelectionRef", ptmin);
+  }
   
   // let W's decay only to light quarks 
   pythia.readString("24:onMode = off");
@@ -57,6 +97,13 @@ int main(int argc, char ** argv) {
 
   pythia.readString("PartonLevel:ISR = "+ISR);
   pythia.readString("PartonLevel:MPI = "+MPI);
+
+  if (variations == "on") {
+    pythia.readString("UncertaintyBands:doVariations = on");
+    pythia.readString("UncertaintyBands:List = {"
+                      "muR-up isr:muRfac=2.0 fsr:muRfac=2.0, "
+                      "muR-down isr:muRfac=0.5 fsr:muRfac=0.5}");
+  }
   
   // by changing the seed you can get different events
   pythia.readString("Random:setSeed = on");
@@ -73,15 +120,66 @@ int main(int argc, char ** argv) {
   // take the two highest-pt jets, regardless of where they are in pt and rapidity
   Selector jet_selector = SelectorNHardest(2);
 
-  // histograms for later
-  SimpleHist jet_mass(0.0, 150.0, 2.0);
-  SimpleHist mmdt_jet_mass(0.0, 150.0, 2.0);
+  // histograms for later (filled with fine bins, see -rebin)
+  SimpleHist jet_mass(0.0, 150.0, 0.5);
+  SimpleHist mmdt_jet_mass(0.0, 150.0, 0.5);
+  // check -rebin now, so that a bad value does not only show up on
+  // output, after all the events have been generated
+  if (rebin <= 0 || unsigned(rebin) > jet_mass.size()) {
+    cerr << "-rebin must be between 1 and " << jet_mass.size() << " (got " << rebin << ")" << endl;
+    exit(-1);
+  }
+  // the jet pt spectrum falls steeply over a wide range, so use bins
+  // that are uniform in log(pt)
+  VarBinHist jet_pt;
+  jet_pt.declare_log(ptmin, 10*ptmin, 40);
+  // the jet mass for each of the event weights (the nominal one,
+  // then any variations), which are only known after pythia.init()
+  unsigned nweights = pythia.info.nWeights();
+  MultiWeightHist jet_mass_variations(0.0, 150.0, 2.0, nweights);
+  vector<double> event_weights(nweights);
+  // the correlation of the jet mass with the jet pt
+  SimpleHist2D jet_mass_v_pt(0.0, 150.0, 5.0, ptmin, 3*ptmin, 0.05*ptmin);
+  // quantiles of the jet mass (without any binning)
+  QuantileSketch jet_mass_quantiles;
+
+  SharedHistWriter shared_hists;
+  if (shm_name != "") {
+    shared_hists.add("jet mass", jet_mass);
+    shared_hists.add("mMDT jet mass", mmdt_jet_mass);
+    shared_hists.open(shm_name);
+  }
   
+  // sums of the event weights and their squares, for the effective
+  // number of events
+  double sum_weights = 0.0, sum_weights2 = 0.0;
+
+  // the output bin of the target and the sums of the weights and
+  // their squares in it, for its relative error (only used if
+  // target_mass >= 0)
+  unsigned target_bin = (target_mass >= 0) ? jet_mass.bin(target_mass) / rebin : 0;
+  double target_sumw = 0.0, target_sumw2 = 0.0;
+  auto relative_error = [&]() {
+    return (target_sumw > 0) ? sqrt(target_sumw2)/target_sumw : 1.0;
+  };
+
   // Begin event loop. Generate event. Skip if error. List first one.
   for (int iEvent = 0; iEvent < nEvents; ++iEvent) {
     if (iEvent%100 == 0) cout << iEvent << endl;
+    if (shared_hists.active() && iEvent%shm_every == 0) shared_hists.publish(iEvent);
+    // check whether the target precision has been reached
+    if (target_mass >= 0 && iEvent > 0 && iEvent % check_every == 0
+        && relative_error() < precision) {
+      nEvents = iEvent;
+      break;
+    }
     
     if (!pythia.next()) continue;
+    // the event weight (1 unless the generation is biased)
+    double weight = pythia.info.weight();
+    sum_weights  += weight;
+    sum_weights2 += weight*weight;
+    for (unsigned iw = 0; iw < nweights; iw++) event_weights[iw] = pythia.info.weight(iw);
 
     vector<PseudoJet> particles;
     
@@ -95,9 +193,20 @@ int main(int argc, char ** argv) {
     // Cluster particle into jets; 
     vector<PseudoJet> jets = jet_def(particles);
 
+    // bin the masses of the two hardest jets for all the weights
+    double masses[2] = {jets[0].m(), jets[1].m()};
+    jet_mass_variations.add_entries_same_weights(masses, 2, &event_weights[0]);
+
     // then loop over the two hardest jets and bin their mass
     for (unsigned i = 0; i < 2; i++) {
-      jet_mass.add_entry(jets[i].m());
+      jet_mass.add_entry(jets[i].m(), weight);
+      if (target_mass >= 0 && jet_mass.bin(jets[i].m()) / rebin == target_bin) {
+        target_sumw  += weight;
+        target_sumw2 += weight*weight;
+      }
+      jet_mass_quantiles.add(jets[i].m(), weight);
+      jet_pt.add_entry(jets[i].pt(), weight);
+      jet_mass_v_pt.add_entry(jets[i].m(), jets[i].pt(), weight);
 
       // // try the "mMDT(mu=1) - SoftDrop(beta=0) procedure"
       // double zcut = 0.1;
@@ -126,11 +235,14 @@ int main(int argc, char ** argv) {
       //   // to exit the declustering
       //   break;
       // }
-      // mmdt_jet_mass.add_entry(mmdt_jet.m());
+      // mmdt_jet_mass.add_entry(mmdt_jet.m(), weight);
     }
     
   }
+  shared_hists.publish(nEvents);
   pythia.stat();
+  // report any particle ids whose flavour could not be decoded
+  FlavourHolder::print_unknown_summary(cout);
 
 
   // now write the output
@@ -140,12 +252,45 @@ int main(int argc, char ** argv) {
   ofstream file(filename_stream.str());
   file << "# " << cmdline.command_line() << endl;
   file << "# jet_definition = " << jet_def.description() << endl;
+  // the effective number of events, (sum w)^2/(sum w^2), which gives
+  // the statistical power of the weighted events
+  file << "# sum of weights = " << sum_weights << ", effective number of events = "
+       << (sum_weights2 > 0 ? sum_weights*sum_weights/sum_weights2 : 0.0) << endl;
+  file << "# nEvents = " << nEvents << endl;
+  if (target_mass >= 0) file << "# relative error on jet mass bin containing " << target_mass
+                             << " = " << relative_error() << " (target " << precision << ")" << endl;
   
+  file << "# jet mass v. pt correlation coefficient = " << jet_mass_v_pt.correlation() << endl;
+  file << "# jet mass quantiles: p50 = " << jet_mass_quantiles.quantile(0.50)
+       << ", p90 = " << jet_mass_quantiles.quantile(0.90)
+       << ", p99 = " << jet_mass_quantiles.quantile(0.99) << endl;
   file << "# jet mass" << endl;
-  file << jet_mass << endl << endl;
+  file << jet_mass.rebinned(rebin) << endl << endl;
 
   file << "# mMDT jet mass" << endl;
-  file << mmdt_jet_mass << endl << endl;
+  file << mmdt_jet_mass.rebinned(rebin) << endl << endl;
+
+  file << "# jet pt (log bins, divided by the bin width)" << endl;
+  jet_pt.divide_by_binsize();
+  file << jet_pt << endl << endl;
+
+  // the variations go into a file of their own, with one column per
+  // weight (col4 = nominal)
+  ofstream file_variations("main01-variations.out");
+  file_variations << "# " << cmdline.command_line() << endl;
+  file_variations << "# jet mass for weights:";
+  for (unsigned iw = 0; iw < nweights; iw++) {
+    file_variations << " col" << 4+iw << " = " << (iw == 0 ? "nominal" : pythia.info.weightLabel(iw));
+  }
+  file_variations << endl;
+  file_variations << jet_mass_variations;
+
+  // the 2D histogram goes into a file of its own, since its format
+  // (xlo xmid xhi ylo ymid yhi value) differs from the 1D one
+  ofstream file2d("main01-mass-v-pt.out");
+  file2d << "# " << cmdline.command_line() << endl;
+  file2d << "# jet mass (x) v. jet pt (y)" << endl;
+  file2d << jet_mass_v_pt;
 
   return 0;
 }